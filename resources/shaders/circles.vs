@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// per-boid position, each boid is drawn three times in a row
+layout (location = 1) in float iPositionX;
+layout (location = 2) in float iPositionY;
+layout (location = 3) in float iPositionZ;
+
+// per-frame camera data shared by every program
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+uniform float radius;
+
+void main(){
+    vec3 position = vec3(iPositionX, iPositionY, iPositionZ);
+
+    // the unit circle lies in xy, the second and third copy in xz and yz
+    vec2 point = aPos.xy * radius;
+    int plane = gl_InstanceID % 3;
+    vec3 offset = plane == 0 ? vec3(point, 0.0) : plane == 1 ? vec3(point.x, 0.0, point.y) : vec3(0.0, point);
+
+    gl_Position = projection * view * vec4(position + offset, 1.0);
+}
@@ -0,0 +1,32 @@
+#version 430 core
+layout (local_size_x = 256) in;
+
+// boid state, six float arrays of stride elements (x, y, z, vx, vy, vz)
+layout (std430, binding = 0) readonly buffer State { float state[]; };
+layout (std430, binding = 3) buffer Cells { uint cells[]; };
+// cell of every boid, followed by its rank inside that cell
+layout (std430, binding = 4) buffer Binning { uint binning[]; };
+
+uniform uint count;
+uniform uint stride;
+uniform uint resolution;
+uniform float bound;
+uniform float cellSize;
+
+// same clamping as SpatialGrid::cellCoordinate()
+uint cellCoordinate(float value){
+    float t = (value + bound) / cellSize;
+    if (!(t >= 0.0)) return 0u;
+    return min(uint(t), resolution - 1u);
+}
+
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    uint cell = (cellCoordinate(state[2u * stride + i]) * resolution +
+                 cellCoordinate(state[stride + i])) * resolution +
+                 cellCoordinate(state[i]);
+    binning[i] = cell;
+    binning[stride + i] = atomicAdd(cells[cell], 1u);
+}
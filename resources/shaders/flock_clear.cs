@@ -0,0 +1,12 @@
+#version 430 core
+layout (local_size_x = 256) in;
+
+// per-cell boid counts, reset before binning
+layout (std430, binding = 3) buffer Cells { uint cells[]; };
+
+uniform uint cellCount;
+
+void main(){
+    uint cell = gl_GlobalInvocationID.x;
+    if (cell <= cellCount) cells[cell] = 0u;
+}
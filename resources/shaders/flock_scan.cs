@@ -0,0 +1,41 @@
+#version 430 core
+// a single work group turns the cell counts into cell starts
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 3) buffer Cells { uint cells[]; };
+
+uniform uint cellCount;
+
+shared uint partial[256];
+
+void main(){
+    uint thread = gl_LocalInvocationID.x;
+    uint chunk = (cellCount + 255u) / 256u;
+    uint begin = min(thread * chunk, cellCount);
+    uint end = min(begin + chunk, cellCount);
+
+    // every thread sums its own run of cells
+    uint sum = 0u;
+    for (uint cell = begin; cell < end; cell++) {
+        sum += cells[cell];
+    }
+    partial[thread] = sum;
+    barrier();
+
+    // inclusive scan of the 256 partial sums
+    for (uint offset = 1u; offset < 256u; offset <<= 1) {
+        uint value = thread >= offset ? partial[thread - offset] : 0u;
+        barrier();
+        partial[thread] += value;
+        barrier();
+    }
+
+    // exclusive prefix inside the run, cells[cellCount] ends up as the total
+    uint running = partial[thread] - sum;
+    for (uint cell = begin; cell < end; cell++) {
+        uint n = cells[cell];
+        cells[cell] = running;
+        running += n;
+    }
+    if (thread == 255u) cells[cellCount] = partial[255];
+}
@@ -0,0 +1,21 @@
+#version 430 core
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) readonly buffer State { float state[]; };
+// copy of the state sorted by cell
+layout (std430, binding = 2) writeonly buffer Sorted { float sorted[]; };
+layout (std430, binding = 3) readonly buffer Cells { uint cells[]; };
+layout (std430, binding = 4) readonly buffer Binning { uint binning[]; };
+
+uniform uint count;
+uniform uint stride;
+
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    uint slot = cells[binning[i]] + binning[stride + i];
+    for (uint s = 0u; s < 6u; s++) {
+        sorted[s * stride + slot] = state[s * stride + i];
+    }
+}
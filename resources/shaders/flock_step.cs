@@ -0,0 +1,97 @@
+#version 430 core
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) readonly buffer State { float state[]; };
+layout (std430, binding = 1) writeonly buffer Next { float next[]; };
+layout (std430, binding = 2) readonly buffer Sorted { float sorted[]; };
+layout (std430, binding = 3) readonly buffer Cells { uint cells[]; };
+layout (std430, binding = 4) readonly buffer Binning { uint binning[]; };
+
+uniform uint count;
+uniform uint stride;
+uniform uint resolution;
+uniform float bound;
+uniform float cellSize;
+uniform float radius2;
+uniform float separation;
+uniform float cohesion;
+uniform float alignment;
+uniform float maxSpeed;
+uniform float dt;
+
+int cellCoordinate(float value){
+    float t = (value + bound) / cellSize;
+    if (!(t >= 0.0)) return 0;
+    return min(int(t), int(resolution) - 1);
+}
+
+vec3 safeNormalize(vec3 v){
+    float l = length(v);
+    return l > 0.0 ? v / l : vec3(0.0);
+}
+
+void main(){
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count) return;
+
+    vec3 position = vec3(state[i], state[stride + i], state[2u * stride + i]);
+    vec3 velocity = vec3(state[3u * stride + i], state[4u * stride + i], state[5u * stride + i]);
+    uint self = cells[binning[i]] + binning[stride + i];
+
+    // same 3x3 rows of cells as SpatialGrid::forEachRow()
+    int last = int(resolution) - 1;
+    int cx = cellCoordinate(position.x);
+    int cy = cellCoordinate(position.y);
+    int cz = cellCoordinate(position.z);
+    int x0 = max(cx - 1, 0), x1 = min(cx + 1, last);
+
+    vec3 separationSum = vec3(0.0);
+    vec3 cohesionSum = vec3(0.0);
+    vec3 alignmentSum = vec3(0.0);
+    uint total = 0u;
+    for (int z = max(cz - 1, 0); z <= min(cz + 1, last); z++) {
+        for (int y = max(cy - 1, 0); y <= min(cy + 1, last); y++) {
+            uint row = uint((z * int(resolution) + y) * int(resolution));
+            uint end = cells[row + uint(x1) + 1u];
+            for (uint k = cells[row + uint(x0)]; k < end; k++) {
+                vec3 other = vec3(sorted[k], sorted[stride + k], sorted[2u * stride + k]);
+                vec3 d = other - position;
+                if (k != self && dot(d, d) < radius2) {
+                    total++;
+                    separationSum += d;
+                    cohesionSum += other;
+                    alignmentSum += vec3(sorted[3u * stride + k], sorted[4u * stride + k], sorted[5u * stride + k]);
+                }
+            }
+        }
+    }
+
+    // same rules as Flock::steer()
+    vec3 steer = vec3(0.0);
+    if (total > 0u) {
+        steer += -safeNormalize(separationSum) * separation;
+        steer += safeNormalize(cohesionSum / float(total) - position) * cohesion;
+        steer += safeNormalize(alignmentSum / float(total)) * alignment;
+    }
+    velocity += steer / (separation + cohesion + alignment);
+
+    if (length(velocity) > maxSpeed) {
+        velocity /= length(velocity);
+    }
+
+    // wrap around the cube
+    position += velocity * dt;
+    if (position.x < -bound) position.x = bound;
+    if (position.y < -bound) position.y = bound;
+    if (position.z < -bound) position.z = bound;
+    if (position.x > bound) position.x = -bound;
+    if (position.y > bound) position.y = -bound;
+    if (position.z > bound) position.z = -bound;
+
+    next[i] = position.x;
+    next[stride + i] = position.y;
+    next[2u * stride + i] = position.z;
+    next[3u * stride + i] = velocity.x;
+    next[4u * stride + i] = velocity.y;
+    next[5u * stride + i] = velocity.z;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+uniform vec3 color;
+uniform float cellSize;
+uniform float halfSize;
+
+in vec3 local;
+
+out vec4 FragColor;
+
+void main(){
+    // each quad lies just outside the cube on one axis, the grid spans
+    // the other two
+    vec3 outside = abs(local);
+    vec2 plane;
+    if (outside.x >= max(outside.y, outside.z)) plane = local.yz;
+    else if (outside.y >= outside.z) plane = local.xz;
+    else plane = local.xy;
+
+    // distance to the nearest line in pixels, lines are one pixel wide
+    vec2 cells = (plane + halfSize) / cellSize;
+    vec2 pixels = abs(fract(cells - 0.5) - 0.5) / fwidth(cells);
+    float coverage = 1.0 - min(min(pixels.x, pixels.y), 1.0);
+    if (coverage <= 0.0) discard;
+
+    FragColor = vec4(color, coverage);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+// per-frame camera data shared by every program
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+out vec3 local;
+
+void main(){
+    local = aPos;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// per-instance boid state, one float per attribute (structure of arrays)
+layout (location = 1) in float iPositionX;
+layout (location = 2) in float iPositionY;
+layout (location = 3) in float iPositionZ;
+layout (location = 4) in float iVelocityX;
+layout (location = 5) in float iVelocityY;
+layout (location = 6) in float iVelocityZ;
+
+// per-frame camera data shared by every program
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+void main(){
+    vec3 position = vec3(iPositionX, iPositionY, iPositionZ);
+    vec3 velocity = vec3(iVelocityX, iVelocityY, iVelocityZ);
+
+    // same heading as rotating by -atan2(v.z, v.x) around y and then by
+    // atan2(v.y, |v.xz|) around z, built without trigonometry
+    float horizontal = length(velocity.xz);
+    float speed = length(velocity);
+    vec2 yaw = horizontal > 0.0 ? velocity.xz / horizontal : vec2(1.0, 0.0);
+    float cosPitch = speed > 0.0 ? horizontal / speed : 1.0;
+    float sinPitch = speed > 0.0 ? velocity.y / speed : 0.0;
+
+    mat3 heading = mat3(
+        vec3(cosPitch * yaw.x, sinPitch, cosPitch * yaw.y),
+        vec3(-sinPitch * yaw.x, cosPitch, -sinPitch * yaw.y),
+        vec3(-yaw.y, 0.0, yaw.x)
+    );
+
+    gl_Position = projection * view * vec4(heading * aPos + position, 1.0);
+}
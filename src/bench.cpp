@@ -0,0 +1,405 @@
+// headless benchmark of the flock step, links only the simulation module
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "simulation/distributed_flock.hpp"
+#include "simulation/flock.hpp"
+#include "simulation/flock_simulation.hpp"
+#include "simulation/steering.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// same defaults as the viewer
+const unsigned int seed = 42;
+const float boidSize = 0.3536;
+const float bound = 25.f;
+
+struct BenchConfig {
+    std::vector<unsigned int> sizes = {1000, 10000, 100000, 1000000};
+    std::vector<float> radii = {2*boidSize, 8*boidSize};
+    // 0 keeps the initial (random) layout
+    std::vector<unsigned int> reorders = {0, 32};
+    // 0 searches the grid every step
+    std::vector<float> skins = {0.f};
+    // octree opening angles run on top of the grid/list runs
+    std::vector<float> openingAngles;
+    // worker process counts, run on top of the in-process runs
+    std::vector<unsigned int> workers;
+    // 1 reads grid neighbors from the 16-bit copy
+    std::vector<unsigned int> compacts = {0};
+    // far intervals of lod runs, run on top of the grid runs
+    std::vector<unsigned int> lods;
+    // where the flock starts
+    FlockSimulation::Distribution distribution = FlockSimulation::Cube;
+    unsigned int threads = 0;
+    unsigned int minSteps = 3;
+    unsigned int maxSteps = 1000;
+    double minSeconds = 1.0;
+    float dt = 1.f / 120.f;
+    bool json = false;
+};
+
+// one combination of the options above
+struct BenchCase {
+    unsigned int n;
+    float radius;
+    unsigned int reorder;
+    float skin;
+    // negative for the exact search
+    float openingAngle;
+    // 0 steps the flock in-process
+    unsigned int workers;
+    bool compact;
+    // ticks between steps of far boids, 0 steps every boid every tick
+    unsigned int lod;
+};
+
+struct BenchResult {
+    BenchCase run;
+    unsigned long rebuilds;
+    // one step from the final state against the exact in-process float
+    // search, octree, worker and compact runs only
+    double velocityErrorMean;
+    double velocityErrorMax;
+    // boids stepped per tick, averaged over the timed steps
+    double steered;
+    unsigned int threads;
+    unsigned int steps;
+    double seconds;
+    long peakRssKb;
+};
+
+template <typename T>
+std::vector<T> parseList(const char* text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(static_cast<T>(std::stod(item)));
+    }
+    return values;
+}
+
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options]" << std::endl
+              << "  --n LIST          flock sizes, comma separated (default 1000,10000,100000,1000000)" << std::endl
+              << "  --radius LIST     perception radii, comma separated (default 0.7072,2.8288)" << std::endl
+              << "  --reorder LIST    steps between z-order reorders, 0 never (default 0,32)" << std::endl
+              << "  --skin LIST       neighbor list skins, 0 disables the lists (default 0)" << std::endl
+              << "  --octree LIST     octree opening angles, also reports the error against the exact search" << std::endl
+              << "  --compact LIST    1 quantizes the grid copy to 16 bits, also reports the error against floats (default 0)" << std::endl
+              << "  --lod LIST        far-boid intervals of a fixed camera, off-screen boids wait twice as long" << std::endl
+              << "  --workers LIST    slab worker processes, also reports the error against a single process" << std::endl
+              << "  --distribution D  initial layout, cube, sphere or clustered (default cube)" << std::endl
+              << "  --threads N       worker threads, 0 for one per core (default 0)" << std::endl
+              << "  --min-steps N     steps run at least (default 3)" << std::endl
+              << "  --max-steps N     steps run at most (default 1000)" << std::endl
+              << "  --min-time S      seconds run at least, unless max-steps is hit (default 1)" << std::endl
+              << "  --format FORMAT   csv or json (default csv)" << std::endl;
+}
+
+BenchConfig parseArguments(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            std::exit(1);
+        }
+        const char* value = argv[++i];
+        if (arg == "--n") config.sizes = parseList<unsigned int>(value);
+        else if (arg == "--radius") config.radii = parseList<float>(value);
+        else if (arg == "--reorder") config.reorders = parseList<unsigned int>(value);
+        else if (arg == "--skin") config.skins = parseList<float>(value);
+        else if (arg == "--octree") config.openingAngles = parseList<float>(value);
+        else if (arg == "--compact") config.compacts = parseList<unsigned int>(value);
+        else if (arg == "--lod") config.lods = parseList<unsigned int>(value);
+        else if (arg == "--workers") config.workers = parseList<unsigned int>(value);
+        else if (arg == "--distribution") {
+            if (!FlockSimulation::parseDistribution(value, config.distribution)) {
+                usage(argv[0]);
+                std::exit(1);
+            }
+        }
+        else if (arg == "--threads") config.threads = std::atoi(value);
+        else if (arg == "--min-steps") config.minSteps = std::atoi(value);
+        else if (arg == "--max-steps") config.maxSteps = std::atoi(value);
+        else if (arg == "--min-time") config.minSeconds = std::atof(value);
+        else if (arg == "--format") config.json = std::string(value) == "json";
+        else {
+            usage(argv[0]);
+            std::exit(1);
+        }
+    }
+    return config;
+}
+
+void unpack(const BoidStore& state, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities) {
+    positions.resize(state.size());
+    velocities.resize(state.size());
+    for (unsigned int i = 0; i < state.size(); i++) {
+        positions[i] = state.position(i);
+        velocities[i] = state.velocity(i);
+    }
+}
+
+void velocityError(const BoidStore& expected, const BoidStore& actual, double& mean, double& max) {
+    mean = max = 0.0;
+    for (unsigned int i = 0; i < expected.size(); i++) {
+        double error = glm::length(expected.velocity(i) - actual.velocity(i));
+        mean += error;
+        max = std::max(max, error);
+    }
+    if (expected.size() > 0) mean /= expected.size();
+}
+
+// velocity difference after one step with the exact float search and the
+// octree or compact search of run
+void searchError(ThreadPool& pool, const BoidStore& state, const FlockParameters& params, float dt, const BenchCase& run, double& mean, double& max) {
+    std::vector<glm::vec3> positions, velocities;
+    unpack(state, positions, velocities);
+
+    Flock exact(pool, bound), approximate(pool, bound);
+    exact.reset(positions, velocities);
+    approximate.reset(positions, velocities);
+    approximate.setOctree(run.openingAngle >= 0.f, run.openingAngle);
+    approximate.setCompact(run.compact);
+    exact.update(params, dt);
+    approximate.update(params, dt);
+    velocityError(exact.getBoids(), approximate.getBoids(), mean, max);
+}
+
+// viewer-like camera 60 units in front of the cube, boids beyond its
+// center are far
+LodSettings benchLod(unsigned int farInterval) {
+    LodSettings lod;
+    lod.enabled = true;
+    lod.eye = glm::vec3(0.f, 0.f, 60.f);
+    glm::mat4 view = glm::lookAt(lod.eye, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 projection = glm::perspective(glm::radians(40.f), 1020.f / 720.f, 0.1f, 250.f);
+    lod.viewProjection = projection * view;
+    lod.farDistance = 60.f;
+    lod.farInterval = farInterval;
+    lod.hiddenInterval = 2 * farInterval;
+    return lod;
+}
+
+// the cores are split evenly between the worker processes
+BenchResult runDistributed(const BenchConfig& config, const BenchCase& run) {
+    FlockParameters params = {run.radius, 0.12f, 0.12f, 0.12f, 2.f};
+    std::vector<glm::vec3> positions, velocities;
+    {
+        // filled by a pool of its own, joined again before the workers fork
+        ThreadPool pool(config.threads);
+        FlockSimulation::randomFlock(run.n, seed, bound, params.maxSpeed, positions, velocities, config.distribution, &pool);
+    }
+
+    unsigned int threads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    unsigned int threadsPerWorker = std::max(1u, threads / run.workers);
+    unsigned int steps = 0;
+    double seconds = 0.0, errorMean = 0.0, errorMax = 0.0;
+    bool ok = true;
+    {
+        DistributedFlock flock(run.workers, threadsPerWorker, bound);
+        ok = flock.reset(positions, velocities) && flock.update(params, config.dt);
+
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        while (ok && steps < config.maxSteps && (steps < config.minSteps || seconds < config.minSeconds)) {
+            ok = flock.update(params, config.dt);
+            steps++;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        // one more step, in-process from the same state
+        if (ok) {
+            // the pool is only started here, so the workers fork a single thread
+            unpack(flock.gather(), positions, velocities);
+            ThreadPool pool(config.threads);
+            Flock reference(pool, bound);
+            reference.reset(positions, velocities);
+            reference.update(params, config.dt);
+            ok = flock.update(params, config.dt);
+            if (ok) velocityError(reference.getBoids(), flock.gather(), errorMean, errorMax);
+        }
+    }
+    if (!ok) std::exit(1);
+
+    // the workers are reaped by now, so their peak is in RUSAGE_CHILDREN
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    return {run, 0, errorMean, errorMax, static_cast<double>(run.n), threadsPerWorker * run.workers, steps, seconds, std::max(self.ru_maxrss, children.ru_maxrss)};
+}
+
+BenchResult runBenchmark(const BenchConfig& config, const BenchCase& run) {
+    if (run.workers > 0) return runDistributed(config, run);
+
+    ThreadPool pool(config.threads);
+    Flock flock(pool, bound);
+    FlockParameters params = {run.radius, 0.12f, 0.12f, 0.12f, 2.f};
+
+    std::vector<glm::vec3> positions, velocities;
+    FlockSimulation::randomFlock(run.n, seed, bound, params.maxSpeed, positions, velocities, config.distribution, &pool);
+    flock.reset(positions, velocities);
+    flock.setReorderInterval(run.reorder);
+    flock.setNeighborSkin(run.skin);
+    flock.setOctree(run.openingAngle >= 0.f, run.openingAngle);
+    flock.setCompact(run.compact);
+    if (run.lod > 0) {
+        flock.setLod(benchLod(run.lod));
+    }
+    if (run.reorder > 0) {
+        // short runs would otherwise never see the sorted layout
+        flock.reorder();
+    }
+
+    // warm up caches and the grid allocation
+    flock.update(params, config.dt);
+
+    unsigned long warmupRebuilds = flock.getNeighborStats().rebuilds;
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    unsigned int steps = 0;
+    double seconds = 0.0;
+    double steered = 0.0;
+    while (steps < config.maxSteps && (steps < config.minSteps || seconds < config.minSeconds)) {
+        flock.update(params, config.dt);
+        steered += flock.getSteered();
+        steps++;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // rebuilds during the timed steps only
+    unsigned long rebuilds = flock.getNeighborStats().rebuilds - warmupRebuilds;
+
+    double errorMean = 0.0, errorMax = 0.0;
+    if (run.openingAngle >= 0.f || run.compact) {
+        searchError(pool, flock.getOrdered(), params, config.dt, run, errorMean, errorMax);
+    }
+    return {run, rebuilds, errorMean, errorMax, steered / steps, pool.size(), steps, seconds, usage.ru_maxrss};
+}
+
+// every run gets its own process so peak rss is not inherited from larger runs
+bool runIsolated(const BenchConfig& config, const BenchCase& run, BenchResult& result) {
+    int channel[2];
+    if (pipe(channel) != 0) return false;
+
+    pid_t child = fork();
+    if (child < 0) return false;
+    if (child == 0) {
+        close(channel[0]);
+        BenchResult measured = runBenchmark(config, run);
+        ssize_t written = write(channel[1], &measured, sizeof(measured));
+        _exit(written == sizeof(measured) ? 0 : 1);
+    }
+
+    close(channel[1]);
+    ssize_t bytes = read(channel[0], &result, sizeof(result));
+    close(channel[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    return bytes == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void printResult(const BenchConfig& config, const BenchResult& result, bool first) {
+    double stepsPerSecond = result.steps / result.seconds;
+    const BenchCase& run = result.run;
+    double nsPerBoidStep = result.seconds * 1e9 / (static_cast<double>(result.steps) * run.n);
+
+    if (config.json) {
+        std::printf(
+            "%s\n  {\"kernel\": \"%s\", \"threads\": %u, \"workers\": %u, \"n\": %u, \"distribution\": \"%s\", \"radius\": %.4f, \"reorder\": %u, \"skin\": %.3f, \"rebuilds\": %lu, "
+            "\"octree\": %.3f, \"compact\": %d, \"lod\": %u, \"steered\": %.0f, \"velocity_error_mean\": %.6f, \"velocity_error_max\": %.6f, \"steps\": %u, "
+            "\"seconds\": %.6f, \"steps_per_s\": %.3f, \"ns_per_boid_step\": %.3f, \"peak_rss_kb\": %ld}",
+            first ? "" : ",", Steering::selectedName(), result.threads, run.workers, run.n,
+            FlockSimulation::distributionName(config.distribution), run.radius, run.reorder,
+            run.skin, result.rebuilds, run.openingAngle, run.compact ? 1 : 0, run.lod, result.steered, result.velocityErrorMean, result.velocityErrorMax, result.steps,
+            result.seconds, stepsPerSecond, nsPerBoidStep, result.peakRssKb
+        );
+    } else {
+        std::printf(
+            "%s,%u,%u,%u,%s,%.4f,%u,%.3f,%lu,%.3f,%d,%u,%.0f,%.6f,%.6f,%u,%.6f,%.3f,%.3f,%ld\n",
+            Steering::selectedName(), result.threads, run.workers, run.n, FlockSimulation::distributionName(config.distribution), run.radius, run.reorder,
+            run.skin, result.rebuilds, run.openingAngle, run.compact ? 1 : 0, run.lod, result.steered, result.velocityErrorMean, result.velocityErrorMax, result.steps,
+            result.seconds, stepsPerSecond, nsPerBoidStep, result.peakRssKb
+        );
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config = parseArguments(argc, argv);
+
+    if (config.json) {
+        std::printf("[");
+    } else {
+        std::printf("kernel,threads,workers,n,distribution,radius,reorder,skin,rebuilds,octree,compact,lod,steered,velocity_error_mean,velocity_error_max,steps,seconds,steps_per_s,ns_per_boid_step,peak_rss_kb\n");
+    }
+
+    // grid or list runs, then the octree ones, then the worker processes
+    std::vector<BenchCase> runs;
+    for (unsigned int n : config.sizes) {
+        for (float radius : config.radii) {
+            for (unsigned int reorder : config.reorders) {
+                for (unsigned int compact : config.compacts) {
+                    for (float skin : config.skins) {
+                        // the lists read the float state directly
+                        if (compact && skin > 0.f) continue;
+                        runs.push_back({n, radius, reorder, skin, -1.f, 0, compact != 0, 0});
+                    }
+                }
+                for (float openingAngle : config.openingAngles) {
+                    runs.push_back({n, radius, reorder, 0.f, openingAngle, 0, false, 0});
+                }
+                for (unsigned int lod : config.lods) {
+                    if (lod > 0) runs.push_back({n, radius, reorder, 0.f, -1.f, 0, false, lod});
+                }
+            }
+            for (unsigned int workers : config.workers) {
+                if (workers > 0) runs.push_back({n, radius, 0, 0.f, -1.f, workers, false, 0});
+            }
+        }
+    }
+
+    bool first = true;
+    int failures = 0;
+    for (const BenchCase& run : runs) {
+        BenchResult result;
+        if (!runIsolated(config, run, result)) {
+            std::cerr << "run failed: n=" << run.n << " radius=" << run.radius << " reorder=" << run.reorder
+                      << " skin=" << run.skin << " octree=" << run.openingAngle << " workers=" << run.workers << " compact=" << run.compact << " lod=" << run.lod << std::endl;
+            failures++;
+            continue;
+        }
+        printResult(config, result, first);
+        first = false;
+    }
+
+    if (config.json) {
+        std::printf("\n]\n");
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include "capi/boids.h"
+
+#include "simulation/flock_simulation.hpp"
+
+#include <vector>
+
+struct boids_simulation {
+    FlockSimulation simulation;
+
+    boids_simulation(unsigned int threads, float bound) : simulation(threads, bound) {
+    }
+};
+
+static boids_parameters toC(const FlockParameters& params) {
+    return {params.perceptionRadius, params.separation, params.cohesion, params.alignment, params.maxSpeed};
+}
+
+// exceptions must not cross into c, every entry point turns them into
+// its failure value
+template <typename T, typename Body>
+static T guarded(T failure, Body body) {
+    try {
+        return body();
+    } catch (...) {
+        return failure;
+    }
+}
+
+boids_simulation* boids_create(unsigned int count, uint64_t seed, unsigned int threads, float bound) {
+    boids_simulation* simulation = nullptr;
+    try {
+        simulation = new boids_simulation(threads, bound);
+        simulation->simulation.randomize(count, seed);
+    } catch (...) {
+        delete simulation;
+        return nullptr;
+    }
+    return simulation;
+}
+
+// destructors are noexcept, nothing to catch
+void boids_destroy(boids_simulation* simulation) {
+    delete simulation;
+}
+
+int boids_reset(boids_simulation* simulation, const float* positions, const float* velocities, unsigned int count) {
+    if (!simulation || (count > 0 && (!positions || !velocities))) return -1;
+
+    return guarded(-1, [&] {
+        std::vector<glm::vec3> p(count), v(count);
+        for (unsigned int i = 0; i < count; i++) {
+            p[i] = glm::vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+            v[i] = glm::vec3(velocities[3 * i], velocities[3 * i + 1], velocities[3 * i + 2]);
+        }
+        simulation->simulation.reset(p, v);
+        return 0;
+    });
+}
+
+int boids_step(boids_simulation* simulation, unsigned int steps) {
+    return guarded(-1, [&] {
+        simulation->simulation.step(steps);
+        return 0;
+    });
+}
+
+boids_state boids_get_state(boids_simulation* simulation) {
+    return guarded(boids_state{}, [&] {
+        BoidView view = simulation->simulation.state().view();
+        return boids_state{view.count, view.x, view.y, view.z, view.vx, view.vy, view.vz};
+    });
+}
+
+uint64_t boids_get_tick(const boids_simulation* simulation) {
+    return guarded<uint64_t>(0, [&] {
+        return simulation->simulation.getTick();
+    });
+}
+
+boids_parameters boids_default_parameters(void) {
+    return toC(FlockSimulation::DEFAULT_PARAMETERS);
+}
+
+boids_parameters boids_get_parameters(const boids_simulation* simulation) {
+    return guarded(toC(FlockSimulation::DEFAULT_PARAMETERS), [&] {
+        return toC(simulation->simulation.getParameters());
+    });
+}
+
+int boids_set_parameters(boids_simulation* simulation, const boids_parameters* parameters) {
+    return guarded(-1, [&] {
+        simulation->simulation.setParameters({
+            parameters->perception_radius, parameters->separation, parameters->cohesion,
+            parameters->alignment, parameters->max_speed
+        });
+        return 0;
+    });
+}
+
+float boids_get_dt(const boids_simulation* simulation) {
+    return guarded(0.f, [&] {
+        return simulation->simulation.getDt();
+    });
+}
+
+int boids_set_dt(boids_simulation* simulation, float dt) {
+    return guarded(-1, [&] {
+        simulation->simulation.setDt(dt);
+        return 0;
+    });
+}
+
+int boids_set_reorder_interval(boids_simulation* simulation, unsigned int interval) {
+    return guarded(-1, [&] {
+        simulation->simulation.getFlock().setReorderInterval(interval);
+        return 0;
+    });
+}
+
+int boids_set_neighbor_skin(boids_simulation* simulation, float skin) {
+    return guarded(-1, [&] {
+        simulation->simulation.getFlock().setNeighborSkin(skin);
+        return 0;
+    });
+}
+
+int boids_set_octree(boids_simulation* simulation, int enabled, float opening_angle) {
+    return guarded(-1, [&] {
+        simulation->simulation.getFlock().setOctree(enabled != 0, opening_angle);
+        return 0;
+    });
+}
+
+int boids_set_compact(boids_simulation* simulation, int enabled) {
+    return guarded(-1, [&] {
+        simulation->simulation.getFlock().setCompact(enabled != 0);
+        return 0;
+    });
+}
@@ -0,0 +1,72 @@
+#ifndef CAPI_BOIDS_H_
+#define CAPI_BOIDS_H_
+
+/* C interface of libboids. every boids_simulation is independent: its own
+ * state, parameters and worker threads, so many can run concurrently from
+ * different threads. a single simulation must not be used from two threads
+ * at once. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct boids_simulation boids_simulation;
+
+typedef struct {
+    float perception_radius;
+    float separation;
+    float cohesion;
+    float alignment;
+    float max_speed;
+} boids_parameters;
+
+/* structure-of-arrays view of the flock indexed by boid id. the arrays
+ * belong to the simulation and stay valid until the next step, reset or
+ * destroy call on it. */
+typedef struct {
+    unsigned int count;
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* vx;
+    const float* vy;
+    const float* vz;
+} boids_state;
+
+/* a random flock of count boids inside the cube [-bound, bound]^3, threads 0
+ * means one per core. returns NULL when it cannot be allocated. */
+boids_simulation* boids_create(unsigned int count, uint64_t seed, unsigned int threads, float bound);
+void boids_destroy(boids_simulation* simulation);
+
+/* replaces the flock, positions and velocities hold count xyz triples.
+ * returns 0 on success, -1 on invalid arguments or when out of memory. */
+int boids_reset(boids_simulation* simulation, const float* positions, const float* velocities, unsigned int count);
+
+/* advances the flock by steps ticks of boids_get_dt() seconds. returns 0 on
+ * success, -1 when out of memory; the flock may then be partly stepped. */
+int boids_step(boids_simulation* simulation, unsigned int steps);
+
+/* a state with count 0 and no arrays when out of memory */
+boids_state boids_get_state(boids_simulation* simulation);
+uint64_t boids_get_tick(const boids_simulation* simulation);
+
+boids_parameters boids_default_parameters(void);
+/* the setters return 0 on success, -1 when out of memory */
+boids_parameters boids_get_parameters(const boids_simulation* simulation);
+int boids_set_parameters(boids_simulation* simulation, const boids_parameters* parameters);
+float boids_get_dt(const boids_simulation* simulation);
+int boids_set_dt(boids_simulation* simulation, float dt);
+
+/* neighbor search settings, see the README */
+int boids_set_reorder_interval(boids_simulation* simulation, unsigned int interval);
+int boids_set_neighbor_skin(boids_simulation* simulation, float skin);
+int boids_set_octree(boids_simulation* simulation, int enabled, float opening_angle);
+int boids_set_compact(boids_simulation* simulation, int enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* CAPI_BOIDS_H_ */
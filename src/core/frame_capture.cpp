@@ -0,0 +1,221 @@
+#include "core/frame_capture.hpp"
+
+#include "utils/profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+// how long a fence is waited for at a time, it should be long signaled
+const GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+
+FrameCapture::~FrameCapture() {
+    this->close();
+}
+
+bool FrameCapture::open(const std::string& path, unsigned int width, unsigned int height, unsigned int fps, unsigned int samples, unsigned int ring) {
+    this->close();
+    if (width == 0 || height == 0 || !this->writer.open(path, width, height, fps)) return false;
+    this->width = width;
+    this->height = height;
+
+    GLint maxSamples = 1;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    samples = std::min<unsigned int>(std::max(samples, 1u), std::max(maxSamples, 1));
+
+    // the scene is drawn multisampled, then resolved into a plain buffer
+    // that glReadPixels can read
+    glGenFramebuffers(1, &this->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glGenRenderbuffers(1, &this->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->colorBuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorBuffer);
+    glGenRenderbuffers(1, &this->depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->depthBuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->depthBuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glGenFramebuffers(1, &this->resolveFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->resolveFramebuffer);
+    glGenRenderbuffers(1, &this->resolveBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->resolveBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->resolveBuffer);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        std::cerr << "could not create a " << width << "x" << height << " capture framebuffer" << std::endl;
+        this->release();
+        this->writer.close();
+        return false;
+    }
+
+    GLsizeiptr frameSize = static_cast<GLsizeiptr>(width) * height * 4;
+    this->slots.resize(std::max(ring, 1u));
+    for (Slot& slot : this->slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->head = 0;
+
+    // a couple of frames more than the ring, so a slow write does not stall
+    // the render thread right away
+    this->pending.clear();
+    this->spare.assign(this->slots.size() + 2, std::vector<uint8_t>(frameSize));
+    this->stopping = false;
+    this->failed = false;
+    this->frames = 0;
+    this->encoderWaits = 0;
+    this->readbackSeconds = 0.0;
+    this->started = Clock::now();
+    this->encoder = std::thread(&FrameCapture::encode, this);
+    return true;
+}
+
+void FrameCapture::bind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glViewport(0, 0, this->width, this->height);
+}
+
+void FrameCapture::capture() {
+    PROFILE_SCOPE(Profiler::Capture);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->resolveFramebuffer);
+    glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, this->width, this->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->resolveFramebuffer);
+
+    // the slot comes back around after ring frames, its copy is done by now
+    Slot& slot = this->slots[this->head];
+    if (slot.fence) this->collect(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->head = (this->head + 1) % this->slots.size();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+}
+
+void FrameCapture::collect(Slot& slot) {
+    std::vector<uint8_t> frame;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->spare.empty()) {
+            this->encoderWaits++;
+            this->freed.wait(lock, [this]() { return !this->spare.empty(); });
+        }
+        frame = std::move(this->spare.back());
+        this->spare.pop_back();
+    }
+
+    Clock::time_point start = Clock::now();
+    GLenum status;
+    do {
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.size(), GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(frame.data(), pixels, frame.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->readbackSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!pixels || status == GL_WAIT_FAILED) this->failed = true;
+        this->pending.push_back(std::move(frame));
+    }
+    this->queued.notify_one();
+    this->frames++;
+}
+
+void FrameCapture::encode() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->queued.wait(lock, [this]() { return this->stopping || !this->pending.empty(); });
+        if (this->pending.empty()) return;
+
+        std::vector<uint8_t> frame = std::move(this->pending.front());
+        this->pending.pop_front();
+        bool skip = this->failed;
+        lock.unlock();
+
+        // after a failed write frames are still returned, only not written
+        bool written = skip || this->writer.write(frame.data());
+
+        lock.lock();
+        if (!written) {
+            this->failed = true;
+            std::cerr << "could not write captured frame " << this->writer.getFrames() << std::endl;
+        }
+        this->spare.push_back(std::move(frame));
+        this->freed.notify_one();
+    }
+}
+
+bool FrameCapture::close() {
+    if (!this->isOpen()) return true;
+
+    // frames still in the ring, oldest first
+    for (unsigned int i = 0; i < this->slots.size(); i++) {
+        Slot& slot = this->slots[(this->head + i) % this->slots.size()];
+        if (slot.fence) this->collect(slot);
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->queued.notify_all();
+    this->encoder.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - this->started).count();
+    unsigned long written = this->writer.getFrames();
+    this->writer.close();
+    this->release();
+
+    std::fprintf(
+        stderr, "captured %lu frames of %ux%u in %.2f s: %.1f frames/s, %.3f ms readback per frame, %lu waits for the encoder\n",
+        written, this->width, this->height, seconds, seconds > 0.0 ? written / seconds : 0.0,
+        this->frames > 0 ? this->readbackSeconds * 1e3 / this->frames : 0.0, this->encoderWaits
+    );
+    return !this->failed;
+}
+
+void FrameCapture::release() {
+    for (Slot& slot : this->slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    this->slots.clear();
+    glDeleteRenderbuffers(1, &this->colorBuffer);
+    glDeleteRenderbuffers(1, &this->depthBuffer);
+    glDeleteRenderbuffers(1, &this->resolveBuffer);
+    glDeleteFramebuffers(1, &this->framebuffer);
+    glDeleteFramebuffers(1, &this->resolveFramebuffer);
+    this->colorBuffer = this->depthBuffer = this->resolveBuffer = 0;
+    this->framebuffer = this->resolveFramebuffer = 0;
+}
+
+bool FrameCapture::isOpen() const {
+    return this->framebuffer != 0;
+}
+
+unsigned long FrameCapture::getFrames() const {
+    return this->frames;
+}
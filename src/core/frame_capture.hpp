@@ -0,0 +1,82 @@
+#ifndef CORE_FRAME_CAPTURE_HPP_
+#define CORE_FRAME_CAPTURE_HPP_
+
+#include "glad/glad.h"
+
+#include "utils/video_writer.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// renders into a multisampled framebuffer object and streams the frames to
+// a VideoWriter. glReadPixels writes into a ring of pixel buffer objects,
+// so it only queues a copy; a frame is mapped once the ring comes back
+// around to it, a few frames later when the gpu is long done with it. the
+// conversion and the file writes happen on an encoder thread.
+class FrameCapture {
+    private:
+        struct Slot {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+        };
+
+        unsigned int width = 0;
+        unsigned int height = 0;
+        GLuint framebuffer = 0;
+        GLuint colorBuffer = 0;
+        GLuint depthBuffer = 0;
+        GLuint resolveFramebuffer = 0;
+        GLuint resolveBuffer = 0;
+        std::vector<Slot> slots;
+        unsigned int head = 0;
+
+        // encoder thread, frames travel between the two lists
+        VideoWriter writer;
+        std::thread encoder;
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable freed;
+        std::deque<std::vector<uint8_t>> pending;
+        std::vector<std::vector<uint8_t>> spare;
+        bool stopping = false;
+        bool failed = false;
+
+        // report
+        std::chrono::steady_clock::time_point started;
+        unsigned long frames = 0;
+        unsigned long encoderWaits = 0;
+        double readbackSeconds = 0.0;
+
+        void collect(Slot& slot);
+        void encode();
+        void release();
+
+    public:
+        FrameCapture() = default;
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+        ~FrameCapture();
+
+        // ring pbos in flight, more hide more latency at width * height * 4
+        // bytes each. needs a current context, false if the framebuffer or
+        // the file cannot be created
+        bool open(const std::string& path, unsigned int width, unsigned int height, unsigned int fps, unsigned int samples = 4, unsigned int ring = 3);
+        // draws of the frame go to the capture framebuffer after this
+        void bind();
+        // queues the readback of the frame drawn since bind()
+        void capture();
+        // waits for the frames in flight and the encoder, then prints the
+        // throughput. false if any frame could not be written
+        bool close();
+
+        bool isOpen() const;
+        unsigned long getFrames() const;
+};
+
+#endif  // CORE_FRAME_CAPTURE_HPP_
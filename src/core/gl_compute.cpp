@@ -0,0 +1,28 @@
+#include "core/gl_compute.hpp"
+
+#include <iostream>
+
+GLCompute::DispatchComputeProc GLCompute::dispatchCompute = nullptr;
+GLCompute::MemoryBarrierProc GLCompute::memoryBarrier = nullptr;
+
+bool GLCompute::load(GLADloadproc load) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 3)) {
+        std::cerr << "Compute shaders need OpenGL 4.3, context is " << major << "." << minor << std::endl;
+        return false;
+    }
+
+    dispatchCompute = reinterpret_cast<DispatchComputeProc>(load("glDispatchCompute"));
+    memoryBarrier = reinterpret_cast<MemoryBarrierProc>(load("glMemoryBarrier"));
+    if (!available()) {
+        std::cerr << "Failed to load the OpenGL 4.3 compute functions" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GLCompute::available() {
+    return dispatchCompute && memoryBarrier;
+}
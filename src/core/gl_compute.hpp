@@ -0,0 +1,37 @@
+#ifndef CORE_GL_COMPUTE_HPP_
+#define CORE_GL_COMPUTE_HPP_
+
+#include "glad/glad.h"
+
+// the bundled glad only covers opengl 3.3 core, the few opengl 4.3 entry
+// points and enums used by compute shaders are loaded here instead
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+
+namespace GLCompute {
+    typedef void (APIENTRYP DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+    typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+
+    extern DispatchComputeProc dispatchCompute;
+    extern MemoryBarrierProc memoryBarrier;
+
+    // needs a current context of version 4.3 or newer, false otherwise
+    bool load(GLADloadproc load);
+    bool available();
+}
+
+#endif  // CORE_GL_COMPUTE_HPP_
@@ -0,0 +1,104 @@
+#include "core/headless_context.hpp"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+HeadlessContext::~HeadlessContext() {
+    this->destroy();
+}
+
+static bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) return false;
+    size_t length = std::strlen(name);
+    for (const char* found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+        bool start = found == extensions || found[-1] == ' ';
+        bool end = found[length] == ' ' || found[length] == '\0';
+        if (start && end) return true;
+    }
+    return false;
+}
+
+bool HeadlessContext::create(int major, int minor) {
+    this->destroy();
+
+    // the surfaceless platform needs no display server or gpu device file
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        this->display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (this->display == EGL_NO_DISPLAY) {
+        this->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint versionMajor = 0, versionMinor = 0;
+    if (this->display == EGL_NO_DISPLAY || !eglInitialize(this->display, &versionMajor, &versionMinor)) {
+        std::cerr << "no EGL display for offscreen rendering" << std::endl;
+        this->display = EGL_NO_DISPLAY;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL has no desktop OpenGL" << std::endl;
+        this->destroy();
+        return false;
+    }
+
+    EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(this->display, configAttributes, &config, 1, &configs);
+
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    if (configs > 0) {
+        // a throwaway pbuffer, drivers without surfaceless contexts need one
+        EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        this->surface = eglCreatePbufferSurface(this->display, config, pbufferAttributes);
+        this->context = eglCreateContext(this->display, config, EGL_NO_CONTEXT, contextAttributes);
+    } else if (hasExtension(eglQueryString(this->display, EGL_EXTENSIONS), "EGL_KHR_no_config_context")) {
+        this->context = eglCreateContext(this->display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    }
+
+    if (this->context == EGL_NO_CONTEXT || !eglMakeCurrent(this->display, this->surface, this->surface, this->context)) {
+        std::cerr << "could not create an OpenGL " << major << "." << minor << " core context for offscreen rendering" << std::endl;
+        this->destroy();
+        return false;
+    }
+    if (!gladLoadGLLoader(HeadlessContext::loader())) {
+        std::cerr << "could not load OpenGL functions" << std::endl;
+        this->destroy();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (this->display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (this->context != EGL_NO_CONTEXT) eglDestroyContext(this->display, this->context);
+    if (this->surface != EGL_NO_SURFACE) eglDestroySurface(this->display, this->surface);
+    eglTerminate(this->display);
+    this->context = EGL_NO_CONTEXT;
+    this->surface = EGL_NO_SURFACE;
+    this->display = EGL_NO_DISPLAY;
+}
+
+GLADloadproc HeadlessContext::loader() {
+    return (GLADloadproc)eglGetProcAddress;
+}
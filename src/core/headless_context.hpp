@@ -0,0 +1,32 @@
+#ifndef CORE_HEADLESS_CONTEXT_HPP_
+#define CORE_HEADLESS_CONTEXT_HPP_
+
+#include "glad/glad.h"
+
+#include <EGL/egl.h>
+
+// opengl core context without a window, for offscreen rendering. uses
+// mesa's surfaceless platform when there is one and a 1x1 pbuffer on the
+// default display otherwise, so it works on servers without a display
+// (llvmpipe included). rendering goes to framebuffer objects.
+class HeadlessContext {
+    private:
+        EGLDisplay display = EGL_NO_DISPLAY;
+        EGLSurface surface = EGL_NO_SURFACE;
+        EGLContext context = EGL_NO_CONTEXT;
+
+    public:
+        HeadlessContext() = default;
+        HeadlessContext(const HeadlessContext&) = delete;
+        HeadlessContext& operator=(const HeadlessContext&) = delete;
+        ~HeadlessContext();
+
+        // makes the context current and loads glad, false when the driver
+        // has no such version
+        bool create(int major, int minor);
+        void destroy();
+
+        static GLADloadproc loader();
+};
+
+#endif  // CORE_HEADLESS_CONTEXT_HPP_
@@ -0,0 +1,110 @@
+#include "core/instanced_mesh.hpp"
+
+#include "utils/render_stats.hpp"
+
+InstancedMesh::InstancedMesh(MeshArena& arena, std::vector<float>&& vertices, std::vector<GLuint>&& indices, unsigned int streams)
+    : Mesh(arena, std::move(vertices), std::move(indices)), streams(streams) {
+    glGenBuffers(1, &this->instanceVBO);
+}
+
+InstancedMesh::InstancedMesh(MeshArena& arena, std::vector<float>&& vertices, unsigned int streams, unsigned int divisor)
+    : Mesh(arena, std::move(vertices)), streams(streams), divisor(divisor > 0 ? divisor : 1) {
+    glGenBuffers(1, &this->instanceVBO);
+}
+
+InstancedMesh::~InstancedMesh() {
+    glDeleteBuffers(1, &this->instanceVBO);
+    if (this->VAO)
+        glDeleteVertexArrays(1, &this->VAO);
+}
+
+void InstancedMesh::bindVertexArray() {
+    if (this->VAO) {
+        glBindVertexArray(this->VAO);
+        return;
+    }
+
+    glGenVertexArrays(1, &this->VAO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->arena.getVertexBuffer());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->arena.getIndexBuffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+// attribute s reads its own array, advancing once every divisor instances
+static void pointAttributes(unsigned int streams, unsigned int stride, unsigned int divisor) {
+    for (unsigned int s = 0; s < streams; s++) {
+        GLuint location = s + 1;
+        glVertexAttribPointer(location, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(s * stride * sizeof(float)));
+        glVertexAttribDivisor(location, divisor);
+        glEnableVertexAttribArray(location);
+    }
+}
+
+void InstancedMesh::reserve(unsigned int count) {
+    // grow with some slack so a slowly growing flock does not reallocate every frame
+    this->capacity = count + count / 2;
+
+    this->bindVertexArray();
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->streams * this->capacity * sizeof(float), nullptr, GL_STREAM_DRAW);
+    pointAttributes(this->streams, this->capacity, this->divisor);
+    this->external = false;
+
+    glBindVertexArray(0);
+}
+
+void InstancedMesh::update(const float* const data[], unsigned int count) {
+    if (count > this->capacity || this->external) {
+        this->reserve(count);
+    }
+    this->instances = count;
+
+    // orphan last frame's storage so the upload never waits on the gpu
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    RenderStats::bind();
+    glBufferData(GL_ARRAY_BUFFER, this->streams * this->capacity * sizeof(float), nullptr, GL_STREAM_DRAW);
+    for (unsigned int s = 0; s < this->streams; s++) {
+        glBufferSubData(GL_ARRAY_BUFFER, s * this->capacity * sizeof(float), count * sizeof(float), data[s]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedMesh::bind(GLuint buffer, unsigned int stride, unsigned int count) {
+    this->instances = count;
+    this->external = true;
+
+    this->bindVertexArray();
+    RenderStats::bind();
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    RenderStats::bind();
+    pointAttributes(this->streams, stride, this->divisor);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedMesh::drawInstanced() {
+    if (this->instances == 0) return;
+
+    glBindVertexArray(this->VAO);
+    RenderStats::bind();
+    unsigned int copies = this->instances * this->divisor;
+    if (this->range.indexCount == 0) {
+        glDrawArraysInstanced(this->drawMode, this->range.baseVertex, this->range.vertexCount, copies);
+        RenderStats::draw(static_cast<unsigned long>(this->range.vertexCount) * copies);
+    } else {
+        void* first = (void*)(this->range.firstIndex * sizeof(GLuint));
+        glDrawElementsInstancedBaseVertex(this->drawMode, this->range.indexCount, GL_UNSIGNED_INT, first, copies, this->range.baseVertex);
+        RenderStats::draw(static_cast<unsigned long>(this->range.indexCount) * copies);
+    }
+    glBindVertexArray(0);
+}
+
+GLuint InstancedMesh::getInstanceBuffer() const {
+    return this->instanceVBO;
+}
+
+unsigned int InstancedMesh::getStride() const {
+    return this->capacity;
+}
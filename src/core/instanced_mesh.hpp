@@ -0,0 +1,47 @@
+#ifndef CORE_INSTANCED_MESH_HPP_
+#define CORE_INSTANCED_MESH_HPP_
+
+#include "glad/glad.h"
+
+#include "core/mesh.hpp"
+
+#include <vector>
+
+// arena mesh drawn once per instance with a single draw call, through its
+// own vertex array since the instance attributes differ. instance data is
+// streamed every frame as separate float arrays (one per attribute,
+// starting at location 1) packed back to back in one buffer. with a
+// divisor d every element is drawn d times in a row, gl_InstanceID % d
+// tells the copies apart.
+class InstancedMesh : public Mesh {
+    private:
+        GLuint VAO = 0;
+        GLuint instanceVBO = 0;
+        unsigned int streams;
+        unsigned int divisor = 1;
+        unsigned int capacity = 0;
+        unsigned int instances = 0;
+        // attributes point at a buffer owned elsewhere
+        bool external = false;
+
+        void reserve(unsigned int count);
+        // created on first use, the arena must be uploaded by then
+        void bindVertexArray();
+
+    public:
+        InstancedMesh(MeshArena& arena, std::vector<float>&& vertices, std::vector<GLuint>&& indices, unsigned int streams);
+        // not indexed, drawn with the default line loop mode
+        InstancedMesh(MeshArena& arena, std::vector<float>&& vertices, unsigned int streams, unsigned int divisor = 1);
+        ~InstancedMesh();
+        void update(const float* const data[], unsigned int count);
+        // reads the instances straight from another buffer with the same
+        // layout, arrays of stride floats, e.g. a compute shader's output
+        void bind(GLuint buffer, unsigned int stride, unsigned int count);
+        void drawInstanced();
+
+        // what update() streamed, for other meshes to bind()
+        GLuint getInstanceBuffer() const;
+        unsigned int getStride() const;
+};
+
+#endif  // CORE_INSTANCED_MESH_HPP_
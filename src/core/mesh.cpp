@@ -1,30 +1,29 @@
 #include "core/mesh.hpp"
 
-Mesh::Mesh(const std::vector<float>& vertices, const std::vector<GLuint>& indices)
-    : vertices(vertices), indices(indices) {
-    this->drawMode = GL_TRIANGLES;
-    this->setup(true);
-}
+#include "utils/render_stats.hpp"
 
-Mesh::Mesh(const std::vector<float>& vertices) : vertices(vertices) {
-    this->setup(false);
+Mesh::Mesh(MeshArena& arena, std::vector<float>&& vertices, std::vector<GLuint>&& indices)
+    : arena(arena) {
+    this->range = arena.add(std::move(vertices), std::move(indices));
+    this->drawMode = GL_TRIANGLES;
 }
 
-Mesh::~Mesh() {
-    glDeleteBuffers(1, &VBO);
-    if (this->EBO)
-        glDeleteBuffers(1, &this->EBO);
-    glDeleteVertexArrays(1, &this->VAO);
+Mesh::Mesh(MeshArena& arena, std::vector<float>&& vertices) : arena(arena) {
+    this->range = arena.add(std::move(vertices), std::vector<GLuint>());
 }
 
 void Mesh::draw() {
-    glBindVertexArray(this->VAO);
+    glBindVertexArray(this->arena.getVertexArray());
+    RenderStats::bind();
 
     // select draw function
-    if (!this->EBO) {
-        glDrawArrays(this->drawMode, 0, vertices.size()/3);
+    if (this->range.indexCount == 0) {
+        glDrawArrays(this->drawMode, this->range.baseVertex, this->range.vertexCount);
+        RenderStats::draw(this->range.vertexCount);
     } else {
-        glDrawElements(drawMode, indices.size(), GL_UNSIGNED_INT, 0);
+        void* first = (void*)(this->range.firstIndex * sizeof(GLuint));
+        glDrawElementsBaseVertex(this->drawMode, this->range.indexCount, GL_UNSIGNED_INT, first, this->range.baseVertex);
+        RenderStats::draw(this->range.indexCount);
     }
 
     glBindVertexArray(0);
@@ -33,24 +32,3 @@ void Mesh::draw() {
 void Mesh::setDrawMode(GLuint mode) {
     this->drawMode = mode;
 }
-
-void Mesh::setup(bool withIndices) {
-    glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
-
-    glGenBuffers(1, &this->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-
-    if (withIndices) {
-        glGenBuffers(1, &this->EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-    }
-
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(0);
-}
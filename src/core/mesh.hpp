@@ -3,20 +3,20 @@
 
 #include "glad/glad.h"
 
+#include "core/mesh_arena.hpp"
+
 #include <vector>
 
+// a range of a MeshArena, drawable once the arena is uploaded
 class Mesh {
     protected:
-        std::vector<float> vertices;
-        std::vector<GLuint> indices;
+        const MeshArena& arena;
+        MeshArena::Range range;
         GLuint drawMode = GL_LINE_LOOP;
-        GLuint VAO = 0, VBO = 0, EBO = 0;
 
     public:
-        Mesh(const std::vector<float>& vertices, const std::vector<GLuint>& indices);
-        Mesh(const std::vector<float>& vertices);
-        ~Mesh();
-        void setup(bool withIndices);
+        Mesh(MeshArena& arena, std::vector<float>&& vertices, std::vector<GLuint>&& indices);
+        Mesh(MeshArena& arena, std::vector<float>&& vertices);
         void draw();
         void setDrawMode(GLuint mode);
 };
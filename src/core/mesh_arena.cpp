@@ -0,0 +1,81 @@
+#include "core/mesh_arena.hpp"
+
+#include <iostream>
+
+MeshArena::~MeshArena() {
+    glDeleteBuffers(1, &this->VBO);
+    glDeleteBuffers(1, &this->EBO);
+    glDeleteVertexArrays(1, &this->VAO);
+}
+
+MeshArena::Range MeshArena::add(std::vector<float>&& vertices, std::vector<GLuint>&& indices) {
+    Range range;
+    if (this->isUploaded()) {
+        std::cerr << "meshes cannot be added to an uploaded arena" << std::endl;
+        return range;
+    }
+
+    range.baseVertex = this->vertexFloats / 3;
+    range.vertexCount = vertices.size() / 3;
+    range.firstIndex = this->indexCount;
+    range.indexCount = indices.size();
+    this->vertexFloats += vertices.size();
+    this->indexCount += indices.size();
+
+    this->vertices.push_back(std::move(vertices));
+    if (!indices.empty()) this->indices.push_back(std::move(indices));
+
+    return range;
+}
+
+void MeshArena::upload() {
+    if (this->isUploaded()) return;
+
+    glGenVertexArrays(1, &this->VAO);
+    glBindVertexArray(this->VAO);
+
+    glGenBuffers(1, &this->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, this->vertexFloats * sizeof(float), nullptr, GL_STATIC_DRAW);
+    GLintptr offset = 0;
+    for (const std::vector<float>& mesh : this->vertices) {
+        glBufferSubData(GL_ARRAY_BUFFER, offset, mesh.size() * sizeof(float), mesh.data());
+        offset += mesh.size() * sizeof(float);
+    }
+
+    glGenBuffers(1, &this->EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indexCount * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    offset = 0;
+    for (const std::vector<GLuint>& mesh : this->indices) {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, mesh.size() * sizeof(GLuint), mesh.data());
+        offset += mesh.size() * sizeof(GLuint);
+    }
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // the gpu has its own copy now
+    this->vertices = std::vector<std::vector<float>>();
+    this->indices = std::vector<std::vector<GLuint>>();
+}
+
+bool MeshArena::isUploaded() const {
+    return this->VAO != 0;
+}
+
+GLuint MeshArena::getVertexArray() const {
+    return this->VAO;
+}
+
+GLuint MeshArena::getVertexBuffer() const {
+    return this->VBO;
+}
+
+GLuint MeshArena::getIndexBuffer() const {
+    return this->EBO;
+}
@@ -0,0 +1,47 @@
+#ifndef CORE_MESH_ARENA_HPP_
+#define CORE_MESH_ARENA_HPP_
+
+#include "glad/glad.h"
+
+#include <vector>
+
+// one vertex buffer and one index buffer holding every static mesh. meshes
+// are appended while loading and sent to the gpu together by upload(),
+// which also frees the cpu copies; afterwards each mesh is a range drawn
+// with a base vertex from the shared vertex array.
+class MeshArena {
+    public:
+        struct Range {
+            GLint baseVertex = 0;
+            GLsizei vertexCount = 0;
+            GLsizeiptr firstIndex = 0;
+            GLsizei indexCount = 0;
+        };
+
+    private:
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        // staged as given until upload, so nothing is copied twice
+        std::vector<std::vector<float>> vertices;
+        std::vector<std::vector<GLuint>> indices;
+        GLsizeiptr vertexFloats = 0;
+        GLsizeiptr indexCount = 0;
+
+    public:
+        MeshArena() = default;
+        MeshArena(const MeshArena&) = delete;
+        MeshArena& operator=(const MeshArena&) = delete;
+        ~MeshArena();
+
+        // vertices are xyz triples, indices are relative to the mesh's first
+        // vertex. the vectors are moved in, not copied
+        Range add(std::vector<float>&& vertices, std::vector<GLuint>&& indices);
+        void upload();
+        bool isUploaded() const;
+
+        // position at location 0, bound to the index buffer
+        GLuint getVertexArray() const;
+        GLuint getVertexBuffer() const;
+        GLuint getIndexBuffer() const;
+};
+
+#endif  // CORE_MESH_ARENA_HPP_
@@ -0,0 +1,189 @@
+#include "core/program_cache.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+static GetProgramBinaryProc getProgramBinary = nullptr;
+static ProgramBinaryProc programBinary = nullptr;
+static ProgramParameteriProc programParameteri = nullptr;
+static std::string directory;
+static std::string driver;
+static ProgramCache::Stats counters;
+
+// file layout: magic, key, binary format, binary length, binary
+const char MAGIC[4] = {'B', 'P', 'R', 'G'};
+
+static bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static std::string glString(GLenum name) {
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
+// fnv-1a, stable across runs and builds unlike std::hash
+static uint64_t hash(uint64_t h, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static std::string path(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + "/" + name;
+}
+
+// bytes left after the read position, 0 when the file cannot seek
+static uint64_t remaining(std::FILE* file) {
+    long position = std::ftell(file);
+    if (position < 0 || std::fseek(file, 0, SEEK_END) != 0) return 0;
+    long end = std::ftell(file);
+    if (std::fseek(file, position, SEEK_SET) != 0 || end < position) return 0;
+    return end - position;
+}
+
+bool ProgramCache::load(GLADloadproc load, const std::string& cacheDirectory) {
+    directory.clear();
+    if (cacheDirectory.empty()) return false;
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 1) || hasExtension("GL_ARB_get_program_binary")) {
+        getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(load("glGetProgramBinary"));
+        programBinary = reinterpret_cast<ProgramBinaryProc>(load("glProgramBinary"));
+        programParameteri = reinterpret_cast<ProgramParameteriProc>(load("glProgramParameteri"));
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (!getProgramBinary || !programBinary || !programParameteri || formats < 1) {
+        std::cerr << "OpenGL program binaries are not available, shaders are compiled on every start" << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    if (error) {
+        std::cerr << "could not create the program cache " << cacheDirectory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // a new driver may not read old binaries, or read them wrong
+    driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION) + "\n" + glString(GL_SHADING_LANGUAGE_VERSION);
+    directory = cacheDirectory;
+    return true;
+}
+
+bool ProgramCache::enabled() {
+    return !directory.empty();
+}
+
+std::string ProgramCache::defaultDirectory() {
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    if (cache && cache[0]) return std::string(cache) + "/boids/programs";
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) return std::string(home) + "/.cache/boids/programs";
+    return "";
+}
+
+uint64_t ProgramCache::key(const Sources& sources) {
+    uint64_t h = 14695981039346656037ull;
+    h = hash(h, driver.data(), driver.size());
+    for (const std::pair<GLenum, std::string>& stage : sources) {
+        h = hash(h, &stage.first, sizeof(stage.first));
+        uint64_t length = stage.second.size();
+        h = hash(h, &length, sizeof(length));
+        h = hash(h, stage.second.data(), stage.second.size());
+    }
+    return h;
+}
+
+GLuint ProgramCache::fetch(uint64_t key) {
+    if (!enabled()) return 0;
+    std::FILE* file = std::fopen(path(key).c_str(), "rb");
+    if (!file) return 0;
+
+    char magic[4];
+    uint64_t fileKey = 0;
+    uint32_t format = 0, length = 0;
+    bool valid = std::fread(magic, sizeof(magic), 1, file) == 1 && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && std::fread(&fileKey, sizeof(fileKey), 1, file) == 1 && fileKey == key
+        && std::fread(&format, sizeof(format), 1, file) == 1
+        && std::fread(&length, sizeof(length), 1, file) == 1 && length > 0;
+    // a truncated or corrupt entry must not size the allocation
+    valid = valid && length <= remaining(file);
+    std::vector<char> binary(valid ? length : 0);
+    valid = valid && std::fread(binary.data(), length, 1, file) == 1;
+    std::fclose(file);
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        programBinary(program, format, binary.data(), length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked) return program;
+        glDeleteProgram(program);
+    }
+    counters.rejected++;
+    return 0;
+}
+
+void ProgramCache::prepare(GLuint program) {
+    if (enabled()) programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::store(uint64_t key, GLuint program) {
+    if (!enabled()) return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    // written aside and renamed, so a crash never leaves half a file
+    std::string target = path(key);
+    std::string temporary = target + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        std::cerr << "could not write " << temporary << std::endl;
+        return;
+    }
+    uint32_t format32 = format, length32 = written;
+    bool ok = std::fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+        && std::fwrite(&key, sizeof(key), 1, file) == 1
+        && std::fwrite(&format32, sizeof(format32), 1, file) == 1
+        && std::fwrite(&length32, sizeof(length32), 1, file) == 1
+        && std::fwrite(binary.data(), written, 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), target.c_str()) != 0) {
+        std::cerr << "could not write " << target << std::endl;
+        std::remove(temporary.c_str());
+    }
+}
+
+ProgramCache::Stats& ProgramCache::stats() {
+    return counters;
+}
@@ -0,0 +1,58 @@
+#ifndef CORE_PROGRAM_CACHE_HPP_
+#define CORE_PROGRAM_CACHE_HPP_
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the bundled glad stops at opengl 3.3, program binaries are 4.1 or
+// ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// linked programs kept on disk with glGetProgramBinary, one file per
+// program named after a hash of its sources and of the driver strings. a
+// missing file, or a binary the driver rejects, means compiling from
+// source as usual and writing the file again.
+namespace ProgramCache {
+    // shader stage type and its source
+    typedef std::vector<std::pair<GLenum, std::string>> Sources;
+
+    struct Stats {
+        unsigned int hits = 0;
+        unsigned int compiled = 0;
+        // binaries the driver did not accept, compiled again
+        unsigned int rejected = 0;
+        double seconds = 0.0;
+    };
+
+    // needs a current context. without program binaries in the driver, or
+    // with an empty directory, every program is compiled from source
+    bool load(GLADloadproc load, const std::string& directory);
+    bool enabled();
+    // $XDG_CACHE_HOME/boids/programs or ~/.cache/boids/programs, empty
+    // when neither is set
+    std::string defaultDirectory();
+
+    uint64_t key(const Sources& sources);
+    // a linked program, or 0 when there is no usable binary
+    GLuint fetch(uint64_t key);
+    // call before linking so the driver keeps the binary around
+    void prepare(GLuint program);
+    void store(uint64_t key, GLuint program);
+
+    // programs built since startup, counted by Shader
+    Stats& stats();
+}
+
+#endif  // CORE_PROGRAM_CACHE_HPP_
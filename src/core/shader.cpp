@@ -1,5 +1,11 @@
 #include "core/shader.hpp"
 
+#include "core/gl_compute.hpp"
+#include "core/program_cache.hpp"
+#include "utils/render_stats.hpp"
+
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -32,24 +38,109 @@ GLuint compileShader(GLenum shaderType, const char* source) {
     return shader;
 }
 
+static std::filesystem::file_time_type modifiedTime(const std::string& path) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
+
 // shader functions
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+    this->stages.push_back({GL_VERTEX_SHADER, vertexPath, {}});
+    this->stages.push_back({GL_FRAGMENT_SHADER, fragmentPath, {}});
+    this->ID = this->build();
+    // build the uniform location table
+    this->reflect();
+}
+
+Shader::Shader(const char* computePath) {
+    this->stages.push_back({GL_COMPUTE_SHADER, computePath, {}});
+    this->ID = this->build();
+    this->reflect();
+}
+
+GLuint Shader::build() {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ProgramCache::Stats& stats = ProgramCache::stats();
+
     // read source files
-    std::string vertexSource = readShaderFile(vertexPath);
-    std::string fragmentSource = readShaderFile(fragmentPath);
-    // compile
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource.c_str());
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource.c_str());
-    // create a shader program
-    this->ID = glCreateProgram();
-    glAttachShader(this->ID, vertexShader);
-    glAttachShader(this->ID, fragmentShader);
-    glLinkProgram(this->ID);
-    // remove desnecessary data
-    glDetachShader(this->ID, vertexShader);
-    glDetachShader(this->ID, fragmentShader);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    ProgramCache::Sources sources;
+    for (Stage& stage : this->stages) {
+        stage.modified = modifiedTime(stage.path);
+        sources.emplace_back(stage.type, readShaderFile(stage.path.c_str()));
+    }
+
+    uint64_t key = ProgramCache::key(sources);
+    GLuint program = ProgramCache::fetch(key);
+    if (program) {
+        stats.hits++;
+        stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return program;
+    }
+
+    // compile, a program missing a stage could still link
+    std::vector<GLuint> shaders;
+    for (const std::pair<GLenum, std::string>& source : sources) {
+        GLuint shader = compileShader(source.first, source.second.c_str());
+        if (shader) shaders.push_back(shader);
+    }
+    GLint linked = GL_FALSE;
+    if (shaders.size() == sources.size()) {
+        // create a shader program
+        program = glCreateProgram();
+        ProgramCache::prepare(program);
+        for (GLuint shader : shaders) {
+            glAttachShader(program, shader);
+        }
+        glLinkProgram(program);
+        // remove desnecessary data
+        for (GLuint shader : shaders) {
+            glDetachShader(program, shader);
+        }
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    for (GLuint shader : shaders) {
+        glDeleteShader(shader);
+    }
+
+    if (linked) {
+        ProgramCache::store(key, program);
+        stats.compiled++;
+    } else if (program) {
+        GLint logLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        std::string log(logLength > 0 ? logLength : 1, ' ');
+        glGetProgramInfoLog(program, log.size(), &logLength, &log[0]);
+        std::cerr << "Shader link error in " << this->stages.back().path << ":" << std::endl << log << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
+
+bool Shader::reload() {
+    const Stage* changed = nullptr;
+    for (const Stage& stage : this->stages) {
+        if (modifiedTime(stage.path) != stage.modified) changed = &stage;
+    }
+    if (!changed) return false;
+    std::string path = changed->path;
+
+    // a broken edit keeps the last program that worked
+    GLuint program = this->build();
+    if (!program) return false;
+    if (this->ID) glDeleteProgram(this->ID);
+    this->ID = program;
+
+    this->reflect();
+    for (const std::pair<std::string, GLuint>& block : this->blocks) {
+        GLuint index = glGetUniformBlockIndex(this->ID, block.first.c_str());
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(this->ID, index, block.second);
+    }
+    std::cerr << "reloaded " << path << std::endl;
+    return true;
 }
 
 Shader::~Shader() {
@@ -63,14 +154,125 @@ void Shader::use() {
     glUseProgram(this->ID);
 }
 
-void Shader::uniform(const char* name, glm::mat4& mat) {
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, GL_FALSE, &mat[0][0]);
+// known names keep their index, so handles taken before a reload stay
+// valid; uniforms gone from the program are left with location -1, which
+// glUniform* ignores
+void Shader::reflect() {
+    for (UniformSlot& slot : this->uniforms) {
+        slot.location = -1;
+        slot.size = 0;
+    }
+    if (!this->ID) return;
+
+    GLint count = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    GLint maxLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength > 0 ? maxLength : 1, ' ');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(this->ID, i, name.size(), &length, &size, &type, &name[0]);
+        std::string uniformName = name.substr(0, length);
+
+        // members of uniform blocks have no location of their own
+        GLint location = glGetUniformLocation(this->ID, uniformName.c_str());
+        if (location < 0) continue;
+
+        // arrays are reported as "name[0]", keep the plain name
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos) uniformName.resize(bracket);
+
+        auto known = this->uniformIndex.find(uniformName);
+        if (known != this->uniformIndex.end()) {
+            UniformSlot& slot = this->uniforms[known->second];
+            if (slot.type != type) {
+                std::cerr << "Shader uniform changed type: " << uniformName << std::endl;
+                continue;
+            }
+            slot.location = location;
+            continue;
+        }
+
+        UniformSlot slot;
+        slot.name = uniformName;
+        slot.location = location;
+        slot.type = type;
+        this->uniformIndex[uniformName] = this->uniforms.size();
+        this->uniforms.push_back(slot);
+    }
+}
+
+int Shader::find(const char* name, GLenum type) const {
+    auto it = this->uniformIndex.find(name);
+    if (it == this->uniformIndex.end()) {
+        return -1;
+    }
+    if (this->uniforms[it->second].type != type) {
+        std::cerr << "Shader uniform type mismatch: " << name << std::endl;
+        return -1;
+    }
+    return it->second;
+}
+
+bool Shader::changed(int index, const void* data, unsigned int size) {
+    UniformSlot& slot = this->uniforms[index];
+    if (slot.size == size && std::memcmp(slot.value, data, size * sizeof(float)) == 0) {
+        return false;
+    }
+    slot.size = size;
+    std::memcpy(slot.value, data, size * sizeof(float));
+    return true;
+}
+
+void Shader::set(Uniform<glm::mat4> uniform, const glm::mat4& mat) {
+    if (uniform.valid() && this->changed(uniform.index, &mat[0][0], 16)) {
+        glUniformMatrix4fv(this->uniforms[uniform.index].location, 1, GL_FALSE, &mat[0][0]);
+        RenderStats::uniform();
+    }
+}
+
+void Shader::set(Uniform<glm::vec3> uniform, const glm::vec3& vec) {
+    if (uniform.valid() && this->changed(uniform.index, &vec[0], 3)) {
+        glUniform3fv(this->uniforms[uniform.index].location, 1, &vec[0]);
+        RenderStats::uniform();
+    }
+}
+
+void Shader::set(Uniform<float> uniform, float value) {
+    if (uniform.valid() && this->changed(uniform.index, &value, 1)) {
+        glUniform1f(this->uniforms[uniform.index].location, value);
+        RenderStats::uniform();
+    }
+}
+
+void Shader::set(Uniform<unsigned int> uniform, unsigned int value) {
+    if (uniform.valid() && this->changed(uniform.index, &value, 1)) {
+        glUniform1ui(this->uniforms[uniform.index].location, value);
+        RenderStats::uniform();
+    }
+}
+
+void Shader::bindUniformBlock(const char* name, GLuint binding) {
+    this->blocks.emplace_back(name, binding);
+    GLuint block = glGetUniformBlockIndex(this->ID, name);
+    if (block == GL_INVALID_INDEX) {
+        std::cerr << "Shader uniform block not found: " << name << std::endl;
+        return;
+    }
+    glUniformBlockBinding(this->ID, block, binding);
+}
+
+void Shader::uniform(const char* name, const glm::mat4& mat) {
+    this->set(this->getUniform<glm::mat4>(name), mat);
 }
 
-void Shader::uniform(const char* name, glm::vec3 &vec) {
-    glUniform3fv(glGetUniformLocation(this->ID, name), 1, &vec[0]);
+void Shader::uniform(const char* name, const glm::vec3& vec) {
+    this->set(this->getUniform<glm::vec3>(name), vec);
 }
 
 void Shader::uniform(const char* name, const float x, const float y, const float z) {
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    this->set(this->getUniform<glm::vec3>(name), glm::vec3(x, y, z));
 }
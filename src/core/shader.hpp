@@ -5,17 +5,97 @@
 
 #include "glm/glm.hpp"
 
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 class Shader {
+    public:
+        // handle to an active uniform of type T, resolved once by name and
+        // then used on the hot path without any string lookup
+        template <typename T>
+        struct Uniform {
+            int index = -1;
+            bool valid() const { return index >= 0; }
+        };
+
     private:
+        // every active uniform found at link time with the last value sent,
+        // so uploads of an unchanged value can be skipped
+        struct UniformSlot {
+            std::string name;
+            GLint location;
+            GLenum type;
+            unsigned int size = 0;
+            float value[16];
+        };
+
+        // source files and when they were last read
+        struct Stage {
+            GLenum type;
+            std::string path;
+            std::filesystem::file_time_type modified;
+        };
+
         GLuint ID = 0;
+        std::vector<Stage> stages;
+        std::vector<UniformSlot> uniforms;
+        std::unordered_map<std::string, int> uniformIndex;
+        std::vector<std::pair<std::string, GLuint>> blocks;
+
+        // from the program cache or compiled, 0 on errors
+        GLuint build();
+        void reflect();
+        int find(const char* name, GLenum type) const;
+        bool changed(int index, const void* data, unsigned int size);
 
     public:
         Shader(const char* vertexPath, const char* fragmentPath);
+        // compute program, needs GLCompute::load()
+        explicit Shader(const char* computePath);
         ~Shader();
         void use();
-        void uniform(const char* name, glm::mat4& mat);
-        void uniform(const char* name, glm::vec3 &vec);
+        // builds the program again when a source file changed on disk and
+        // keeps the old one if that fails. uniform handles and block
+        // bindings carry over, true when the program was replaced
+        bool reload();
+
+        template <typename T>
+        Uniform<T> getUniform(const char* name) const;
+        void set(Uniform<glm::mat4> uniform, const glm::mat4& mat);
+        void set(Uniform<glm::vec3> uniform, const glm::vec3& vec);
+        void set(Uniform<float> uniform, float value);
+        void set(Uniform<unsigned int> uniform, unsigned int value);
+
+        // binds a std140 uniform block to a UniformBuffer binding point
+        void bindUniformBlock(const char* name, GLuint binding);
+
+        // lookup by name, one hash lookup per call
+        void uniform(const char* name, const glm::mat4& mat);
+        void uniform(const char* name, const glm::vec3& vec);
         void uniform(const char* name, const float x, const float y, const float z);
 };
 
+template <>
+inline Shader::Uniform<glm::mat4> Shader::getUniform<glm::mat4>(const char* name) const {
+    return {this->find(name, GL_FLOAT_MAT4)};
+}
+
+template <>
+inline Shader::Uniform<glm::vec3> Shader::getUniform<glm::vec3>(const char* name) const {
+    return {this->find(name, GL_FLOAT_VEC3)};
+}
+
+template <>
+inline Shader::Uniform<float> Shader::getUniform<float>(const char* name) const {
+    return {this->find(name, GL_FLOAT)};
+}
+
+template <>
+inline Shader::Uniform<unsigned int> Shader::getUniform<unsigned int>(const char* name) const {
+    return {this->find(name, GL_UNSIGNED_INT)};
+}
+
 #endif  //CORE_SHADER_HPP_
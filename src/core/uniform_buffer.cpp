@@ -0,0 +1,35 @@
+#include "core/uniform_buffer.hpp"
+
+#include "utils/render_stats.hpp"
+
+#include <cstring>
+
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size)
+    : binding(binding), shadow(size, 0) {
+    glGenBuffers(1, &this->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, size, this->shadow.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, this->UBO);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &this->UBO);
+}
+
+void UniformBuffer::update(GLintptr offset, GLsizeiptr size, const void* data) {
+    // skip the upload when nothing changed since last frame
+    unsigned char* cached = this->shadow.data() + offset;
+    if (std::memcmp(cached, data, size) == 0) return;
+    std::memcpy(cached, data, size);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    RenderStats::bind();
+    RenderStats::uniform();
+}
+
+GLuint UniformBuffer::getBinding() const {
+    return this->binding;
+}
@@ -0,0 +1,32 @@
+#ifndef CORE_UNIFORM_BUFFER_HPP_
+#define CORE_UNIFORM_BUFFER_HPP_
+
+#include "glad/glad.h"
+
+#include <vector>
+
+// std140 uniform block storage shared by every program bound to the same
+// binding point (see Shader::bindUniformBlock). keeps a copy of the last
+// contents so unchanged data is not uploaded again.
+class UniformBuffer {
+    private:
+        GLuint UBO = 0;
+        GLuint binding;
+        std::vector<unsigned char> shadow;
+
+    public:
+        UniformBuffer(GLuint binding, GLsizeiptr size);
+        ~UniformBuffer();
+        void update(GLintptr offset, GLsizeiptr size, const void* data);
+        GLuint getBinding() const;
+
+        template <typename T>
+        void update(const T& block);
+};
+
+template <typename T>
+void UniformBuffer::update(const T& block) {
+    this->update(0, sizeof(T), &block);
+}
+
+#endif  // CORE_UNIFORM_BUFFER_HPP_
@@ -0,0 +1,168 @@
+#include "gpu/gpu_flock.hpp"
+
+#include "core/gl_compute.hpp"
+#include "utils/profiler.hpp"
+
+#include <cmath>
+
+// invocations per work group, matches local_size_x of the flock shaders
+const unsigned int GROUP_SIZE = 256;
+// the prefix sum runs in one work group, so the grid stays smaller than on the cpu
+const int MAX_RESOLUTION = 64;
+
+GpuFlock::Kernel::Kernel(const char* path)
+    : program(path),
+      count(program.getUniform<unsigned int>("count")),
+      stride(program.getUniform<unsigned int>("stride")),
+      cellCount(program.getUniform<unsigned int>("cellCount")),
+      resolution(program.getUniform<unsigned int>("resolution")),
+      bound(program.getUniform<float>("bound")),
+      cellSize(program.getUniform<float>("cellSize")),
+      radius2(program.getUniform<float>("radius2")),
+      separation(program.getUniform<float>("separation")),
+      cohesion(program.getUniform<float>("cohesion")),
+      alignment(program.getUniform<float>("alignment")),
+      maxSpeed(program.getUniform<float>("maxSpeed")),
+      dt(program.getUniform<float>("dt")) {
+}
+
+GpuFlock::GpuFlock(float bound)
+    : clear("resources/shaders/flock_clear.cs"),
+      bin("resources/shaders/flock_bin.cs"),
+      scan("resources/shaders/flock_scan.cs"),
+      scatter("resources/shaders/flock_scatter.cs"),
+      step("resources/shaders/flock_step.cs"),
+      bound(bound) {
+    glGenBuffers(2, this->state);
+    glGenBuffers(1, &this->sorted);
+    glGenBuffers(1, &this->cells);
+    glGenBuffers(1, &this->binning);
+}
+
+GpuFlock::~GpuFlock() {
+    glDeleteBuffers(2, this->state);
+    glDeleteBuffers(1, &this->sorted);
+    glDeleteBuffers(1, &this->cells);
+    glDeleteBuffers(1, &this->binning);
+}
+
+void GpuFlock::allocate(unsigned int count) {
+    this->count = count;
+    this->stride = count > 0 ? count : 1;
+
+    size_t stateBytes = 6 * sizeof(float) * this->stride;
+    for (GLuint buffer : {this->state[0], this->state[1], this->sorted}) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, stateBytes, nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->binning);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint) * this->stride, nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::resize(float radius) {
+    this->radius = radius;
+
+    // same layout rule as SpatialGrid: cells are at least one radius wide
+    int cells = static_cast<int>(std::floor(2.f * this->bound / radius));
+    if (cells < 1) cells = 1;
+    if (cells > MAX_RESOLUTION) cells = MAX_RESOLUTION;
+    this->resolution = cells;
+    this->cellSize = 2.f * this->bound / cells;
+
+    // one extra cell holds the total after the prefix sum
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->cells);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * (this->resolution * this->resolution * this->resolution + 1), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities) {
+    this->front = 0;
+    this->allocate(positions.size());
+
+    // upload in the structure-of-arrays layout of the shaders
+    std::vector<float> data(6 * this->stride, 0.f);
+    for (unsigned int i = 0; i < this->count; i++) {
+        data[i] = positions[i].x;
+        data[this->stride + i] = positions[i].y;
+        data[2 * this->stride + i] = positions[i].z;
+        data[3 * this->stride + i] = velocities[i].x;
+        data[4 * this->stride + i] = velocities[i].y;
+        data[5 * this->stride + i] = velocities[i].z;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->state[0]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(float), data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::dispatch(Kernel& kernel, unsigned int invocations) {
+    kernel.program.use();
+    kernel.program.set(kernel.count, this->count);
+    kernel.program.set(kernel.stride, this->stride);
+    kernel.program.set(kernel.cellCount, this->resolution * this->resolution * this->resolution);
+    kernel.program.set(kernel.resolution, this->resolution);
+    kernel.program.set(kernel.bound, this->bound);
+    kernel.program.set(kernel.cellSize, this->cellSize);
+
+    GLCompute::dispatchCompute((invocations + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+    GLCompute::memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuFlock::update(const FlockParameters& params, float dt) {
+    PROFILE_SCOPE(Profiler::FlockUpdate);
+    if (this->count == 0) return;
+
+    // perception radius changed, recompute the cell layout
+    if (params.perceptionRadius != this->radius) {
+        this->resize(params.perceptionRadius);
+    }
+    unsigned int cellCount = this->resolution * this->resolution * this->resolution;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->state[this->front]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, this->state[this->front ^ 1]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, this->sorted);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, this->cells);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, this->binning);
+
+    // bin sort: count boids per cell, turn counts into starts, scatter
+    this->dispatch(this->clear, cellCount + 1);
+    this->dispatch(this->bin, this->count);
+    this->dispatch(this->scan, GROUP_SIZE);
+    this->dispatch(this->scatter, this->count);
+
+    this->step.program.use();
+    this->step.program.set(this->step.radius2, params.perceptionRadius * params.perceptionRadius);
+    this->step.program.set(this->step.separation, params.separation);
+    this->step.program.set(this->step.cohesion, params.cohesion);
+    this->step.program.set(this->step.alignment, params.alignment);
+    this->step.program.set(this->step.maxSpeed, params.maxSpeed);
+    this->step.program.set(this->step.dt, dt);
+    this->dispatch(this->step, this->count);
+
+    // the new state is read as vertex attributes by the renderer
+    GLCompute::memoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    this->front ^= 1;
+}
+
+unsigned int GpuFlock::size() const {
+    return this->count;
+}
+
+GLuint GpuFlock::getBuffer() const {
+    return this->state[this->front];
+}
+
+unsigned int GpuFlock::getStride() const {
+    return this->stride;
+}
+
+void GpuFlock::read(BoidStore& boids) const {
+    boids.resize(this->count);
+    float* streams[] = {boids.x, boids.y, boids.z, boids.vx, boids.vy, boids.vz};
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->state[this->front]);
+    for (unsigned int s = 0; s < 6; s++) {
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, s * this->stride * sizeof(float), this->count * sizeof(float), streams[s]);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,82 @@
+#ifndef GPU_GPU_FLOCK_HPP_
+#define GPU_GPU_FLOCK_HPP_
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include "core/shader.hpp"
+#include "simulation/boid_store.hpp"
+#include "simulation/flock.hpp"
+
+#include <vector>
+
+// flock stepped with opengl 4.3 compute shaders. the state lives in two
+// shader storage buffers used as ping-pong buffers, laid out like a
+// BoidStore (six float arrays of getStride() elements), so the renderer
+// can read the front one as instance attributes without going through the
+// cpu. every step bins the boids into a uniform grid on the gpu (count,
+// prefix sum, scatter) and then runs the same rules as Flock.
+class GpuFlock {
+    private:
+        // one compute program with every uniform the passes may use,
+        // programs that do not declare one get an invalid handle
+        struct Kernel {
+            Shader program;
+            Shader::Uniform<unsigned int> count;
+            Shader::Uniform<unsigned int> stride;
+            Shader::Uniform<unsigned int> cellCount;
+            Shader::Uniform<unsigned int> resolution;
+            Shader::Uniform<float> bound;
+            Shader::Uniform<float> cellSize;
+            Shader::Uniform<float> radius2;
+            Shader::Uniform<float> separation;
+            Shader::Uniform<float> cohesion;
+            Shader::Uniform<float> alignment;
+            Shader::Uniform<float> maxSpeed;
+            Shader::Uniform<float> dt;
+
+            Kernel(const char* path);
+        };
+
+        Kernel clear;
+        Kernel bin;
+        Kernel scan;
+        Kernel scatter;
+        Kernel step;
+
+        GLuint state[2] = {0, 0};
+        GLuint sorted = 0;
+        GLuint cells = 0;
+        GLuint binning = 0;
+        unsigned int front = 0;
+        unsigned int count = 0;
+        unsigned int stride = 0;
+        float bound;
+        float radius = 0.f;
+        unsigned int resolution = 0;
+        float cellSize = 0.f;
+
+        void allocate(unsigned int count);
+        void resize(float radius);
+        void dispatch(Kernel& kernel, unsigned int invocations);
+
+    public:
+        // needs a current opengl 4.3 context and GLCompute::load()
+        GpuFlock(float bound = 25.f);
+        ~GpuFlock();
+        GpuFlock(const GpuFlock&) = delete;
+        GpuFlock& operator=(const GpuFlock&) = delete;
+
+        void reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+        void update(const FlockParameters& params, float dt);
+        unsigned int size() const;
+
+        // storage buffer with the current state and its array stride
+        GLuint getBuffer() const;
+        unsigned int getStride() const;
+
+        // copies the state back to the cpu, waits for the gpu
+        void read(BoidStore& boids) const;
+};
+
+#endif  // GPU_GPU_FLOCK_HPP_
@@ -4,33 +4,50 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "core/frame_capture.hpp"
+#include "core/gl_compute.hpp"
+#include "core/headless_context.hpp"
+#include "core/program_cache.hpp"
 #include "core/shader.hpp"
 #include "core/mesh.hpp"
+#include "core/mesh_arena.hpp"
+#include "core/instanced_mesh.hpp"
+#include "core/uniform_buffer.hpp"
 #include "shapes/primitives.hpp"
 #include "shapes/visualization.hpp"
 #include "camera/orbital_camera.hpp"
+#include "gpu/gpu_flock.hpp"
 #include "utils/imgui.hpp"
+#include "utils/profiler.hpp"
+#include "utils/render_stats.hpp"
+#include "simulation/flock.hpp"
+#include "simulation/flock_simulation.hpp"
+#include "simulation/simulation_thread.hpp"
+#include "simulation/statistics.hpp"
+#include "simulation/trajectory.hpp"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
 #include <vector>
 #include <memory>
 #include <iostream>
-#include <random>
 #include <cmath>
 
-// timing
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
-
 // global settings
 unsigned int windowWidth = 1280;
 unsigned int windowHeight = 720;
 const glm::vec3 UP(0, 1, 0);
 const unsigned int seed = 42;
-std::mt19937 generator(seed);
+// layout of the flock on restart, a FlockSimulation::Distribution
+int startDistribution = FlockSimulation::Cube;
 
 // camera settings
 float theta = 0.f;
@@ -39,8 +56,31 @@ float radius = 100.f;
 OrbitalCamera camera(radius, theta, phi, glm::vec3(0.f, 0.f, 0.f));
 
 // simulation data
-std::vector<glm::vec3> boidPositions;
-std::vector<glm::vec3> boidVelocities;
+// step the flock with compute shaders instead of the simulation thread
+bool gpuBackend = false;
+// gpu ticks run per frame at most before dropping ticks
+const unsigned int MAX_GPU_STEPS = 5;
+// step the flock in this many slab worker processes, 0 in-process
+unsigned int workers = 0;
+
+// gpu times and draw calls per pass, logged from the start when given
+std::string renderLogPath;
+
+// linked programs are kept here between runs, empty compiles every time
+std::string shaderCachePath = ProgramCache::defaultDirectory();
+
+// offscreen capture settings, no window when a path is given
+std::string capturePath;
+unsigned int captureWidth = 1280;
+unsigned int captureHeight = 720;
+unsigned int captureFrames = 600;
+unsigned int captureFps = 60;
+
+// replay settings
+TrajectoryReader replay;
+bool replaying = false;
+int replayFrame = 0;
+double replayTime = 0.0;
 
 // simulation settings
 unsigned int nBoids = 500;
@@ -50,39 +90,109 @@ float w = grids * space / 2.0;
 const float boidSize = 0.3536;
 float maxSpeed = 2.f;
 float perceptionRadius = 8*boidSize;
-float lastPerceptionRadius = perceptionRadius;
 float separationValue = 0.12;
 float cohesionValue = 0.12;
 float alignmentValue = 0.12;
 bool drawCollisionRegion = false;
 bool drawNeighborhood = false;
 bool drawGrid = true;
+// grid lines drawn by a fragment shader on the cube's faces, instead of a
+// line mesh that grows with the square of the grid resolution
+bool shaderGrid = true;
 bool drawBox = true;
 bool running = true;
+float tickRate = 60.f;
+// steps between z-order reorders of the boid arrays, 0 never
+int reorderInterval = 32;
+// extra radius of the cached neighbor lists, 0 searches the grid every tick
+float neighborSkin = 0.5f;
+// approximate far neighbors with an octree, 0 keeps it exact
+bool useOctree = false;
+float openingAngle = 0.5f;
+// 16-bit neighbor copy for grid searches, only used with the skin off
+bool useCompact = false;
+// step far and off-screen boids every few ticks only
+bool useLod = false;
+int lodFarInterval = 2;
+int lodHiddenInterval = 4;
+// simulated seconds per real second
+const float timeScale = 0.5f;
+
+// std140 layout of the Camera uniform block in the shaders
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+};
 
 // imgui settings
 unsigned int menuWidth = 260;
 
-void generateBoids() {
-    boidPositions = std::vector<glm::vec3>();
-    boidVelocities = std::vector<glm::vec3>();
-
-    // random generator
-    std::uniform_real_distribution<float> position(-w + 0.6, +w - 0.6);
-    std::uniform_real_distribution<float> velocity(-maxSpeed, maxSpeed);
-
-    for (unsigned int i = 0; i < nBoids; i++) {
-        boidPositions.push_back(glm::vec3(
-            position(generator),
-            position(generator),
-            position(generator)
-        ));
-        boidVelocities.push_back(glm::vec3(
-            velocity(generator),
-            velocity(generator),
-            velocity(generator)
-        ));
+// the worker halos only reach the next slab, so the radius has to stay below its width
+float maxPerception() {
+    float limit = 20*boidSize;
+    if (workers > 1 && !replaying && !gpuBackend) limit = std::min(limit, 0.99f * 2.f * 25.f / workers);
+    return std::max(limit, boidSize);
+}
+
+FlockParameters flockParameters() {
+    return {perceptionRadius, separationValue, cohesionValue, alignmentValue, maxSpeed};
+}
+
+// starts a new random flock on whichever backend is stepping it
+void restartFlock(SimulationThread& simulation, GpuFlock* gpuFlock) {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> velocities;
+    FlockSimulation::Distribution distribution = static_cast<FlockSimulation::Distribution>(startDistribution);
+    FlockSimulation::randomFlock(nBoids, seed, w, maxSpeed, positions, velocities, distribution, &simulation.pool());
+
+    if (gpuFlock) {
+        gpuFlock->reset(positions, velocities);
+    } else {
+        simulation.reset(std::move(positions), std::move(velocities));
+    }
+}
+
+// steps both backends from the same flock and compares their statistics,
+// single boids drift apart after a while but the flock as a whole must not
+int validateGpuBackend(unsigned int steps) {
+    FlockSimulation flock(0, 25.f);
+    GpuFlock gpuFlock(25.f);
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> velocities;
+    FlockSimulation::randomFlock(nBoids, seed, w, maxSpeed, positions, velocities, FlockSimulation::Cube, &flock.getPool());
+    flock.reset(positions, velocities);
+    gpuFlock.reset(positions, velocities);
+
+    FlockParameters params = flockParameters();
+    flock.setParameters(params);
+    flock.setDt(timeScale / tickRate);
+    flock.step(steps);
+    for (unsigned int i = 0; i < steps; i++) {
+        gpuFlock.update(params, timeScale / tickRate);
+    }
+
+    BoidStore gpuBoids;
+    gpuFlock.read(gpuBoids);
+    FlockStatistics cpu = Statistics::measure(flock.state(), params.perceptionRadius, 25.f);
+    FlockStatistics gpu = Statistics::measure(gpuBoids, params.perceptionRadius, 25.f);
+    Statistics::print(std::cout, "cpu", cpu);
+    Statistics::print(std::cout, "gpu", gpu);
+
+    if (!Statistics::similar(cpu, gpu, 0.1)) {
+        std::cerr << "GPU backend does not match the CPU one after " << steps << " steps" << std::endl;
+        return 1;
     }
+    std::cout << "GPU backend matches the CPU one after " << steps << " steps" << std::endl;
+    return 0;
+}
+
+// name of a new recording in the working directory
+std::string recordingPath() {
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(name, sizeof(name), "boids-%Y%m%d-%H%M%S.trj", std::localtime(&now));
+    return name;
 }
 
 void key_callback(
@@ -96,98 +206,278 @@ void key_callback(
     }
 }
 
-glm::vec3 boidBehavior(unsigned int i, std::vector<glm::vec3> &boidPositions, std::vector<glm::vec3> &boidVelocities) {
-    int total = 0;
-    glm::vec3 separation = glm::vec3(0);
-    glm::vec3 cohesion = glm::vec3(0);
-    glm::vec3 alignment = glm::vec3(0);
-
-    for (unsigned int j = 0; j < boidPositions.size(); j++) {
-        if (j != i) {
-            glm::vec3 distance = boidPositions[j] - boidPositions[i];
-            if (glm::length(distance) < perceptionRadius) {
-                total++;
-                separation += distance;
-                cohesion += boidPositions[j];
-                alignment += boidVelocities[j];
-            }
-        }
-    }
+// the settings panel on the right of the window
+void settingsWindow(SimulationThread& simulation, GpuFlock* gpuFlock, ImFont* fontTitle) {
+    ImVec2 windowPos(windowWidth - menuWidth, 0);
+    ImVec2 windowSize(menuWidth, windowHeight);
 
-    if (total > 0) {
-        separation = -glm::normalize(separation);
-        cohesion /= total;
-        cohesion = glm::normalize(cohesion - boidPositions[i]);
-        alignment /= total;
-        alignment = glm::normalize(alignment);
+    ImGui::SetNextWindowPos(windowPos, ImGuiCond_Appearing);
+    ImGui::SetNextWindowSize(windowSize, ImGuiCond_Appearing);
+    ImGui::Begin("Simulation Settings", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
+    ImGui::TextWrapped("Welcome to Flocking Simulation! Use these controls to adjust visualization settings and simulation parameters.");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::PushFont(fontTitle);
+    ImGui::Text("Visualization:");
+    ImGui::PopFont();
+    ImGui::TextWrapped("Setting what is being rendered.");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::SliderFloat("Altitude", &phi, 0.0f, 90.0f, "%.4f");
+    ImGui::SliderFloat("Azimuth", &theta, 0.0f, 360.0f, "%.4f");
+    ImGui::SliderFloat("Radius", &radius, 0.1f, 200.0f, "%.2f");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Columns(2, "drawingFunctions", false);
+    ImGui::Checkbox("Collision Region", &drawCollisionRegion);
+    ImGui::Checkbox("Percep. Region", &drawNeighborhood); ImGui::NextColumn();
+    ImGui::Checkbox("Cube Background", &drawBox);
+    ImGui::Checkbox("Cube Grid", &drawGrid);
+    ImGui::Checkbox("Shader Grid", &shaderGrid);
+    ImGui::Columns(1);
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::PushFont(fontTitle);
+    ImGui::Text("Behavior:");
+    ImGui::PopFont();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::TextWrapped("Flocking behaviors constant values.");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::SliderFloat("Alignment", &alignmentValue, 0.0f, 1.0f, "%.4f");
+    ImGui::SliderFloat("Cohesion", &cohesionValue, 0.0f, 1.0f, "%.4f");
+    ImGui::SliderFloat("Separation", &separationValue, 0.0f, 1.0f, "%.4f");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::PushFont(fontTitle);
+    ImGui::Text("Boid:");
+    ImGui::PopFont();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::TextWrapped("Settings for an individual boid.");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::SliderFloat("Perception", &perceptionRadius, boidSize, maxPerception(), "%.4f");
+    perceptionRadius = std::min(perceptionRadius, maxPerception());
+    ImGui::SliderFloat("Max. Speed", &maxSpeed, 0, 100, "%.2f");
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::PushFont(fontTitle);
+    ImGui::Text("Simulation:");
+    ImGui::PopFont();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Columns(3, "simulationStatus", false);
+    if (ImGui::Button("Stop", ImVec2(75, 20))) {
+        running = false;
+        simulation.pause();
+    }
+    ImGui::NextColumn();
+    if (ImGui::Button("Play", ImVec2(75, 20))) {
+        running = true;
+        simulation.resume();
     }
+    ImGui::NextColumn();
+    if (ImGui::Button("Restart", ImVec2(75, 20))) {
+        if (replaying) {
+            replayFrame = 0;
+            replayTime = 0.0;
+        } else {
+            restartFlock(simulation, gpuFlock);
+        }
 
-    return separation * separationValue + cohesion * cohesionValue + alignment * alignmentValue;
+    }
+    ImGui::Columns(1);
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    if (replaying) {
+        // seek anywhere in the recording
+        int lastReplayFrame = static_cast<int>(replay.frameCount()) - 1;
+        ImGui::SliderInt("Frame", &replayFrame, 0, lastReplayFrame > 0 ? lastReplayFrame : 0);
+    } else {
+        // applied by Restart
+        ImGui::Combo("Start", &startDistribution, "Cube\0Sphere\0Clustered\0");
+        if (ImGui::SliderFloat("Tick Rate", &tickRate, 10.0f, 240.0f, "%.0f Hz")) {
+            simulation.setTickRate(tickRate);
+        }
+    }
+    // search tuning only applies to the in-process flock
+    if (!replaying && !gpuFlock && workers > 0) {
+        ImGui::Text("Stepped by %u worker processes", workers);
+    }
+    if (!replaying && !gpuFlock && workers == 0) {
+        if (ImGui::SliderInt("Reorder", &reorderInterval, 0, 256, reorderInterval > 0 ? "every %d" : "off")) {
+            simulation.setReorderInterval(reorderInterval);
+        }
+        if (ImGui::SliderFloat("Skin", &neighborSkin, 0.0f, 2.0f, neighborSkin > 0.f ? "%.2f" : "off")) {
+            simulation.setNeighborSkin(neighborSkin);
+        }
+        bool octreeChanged = ImGui::Checkbox("Octree", &useOctree);
+        if (useOctree) {
+            ImGui::SameLine();
+            octreeChanged |= ImGui::SliderFloat("Opening", &openingAngle, 0.0f, 1.5f, "%.2f");
+        }
+        if (octreeChanged) {
+            simulation.setOctree(useOctree, openingAngle);
+        }
+        if (ImGui::Checkbox("Compact", &useCompact)) {
+            simulation.setCompact(useCompact);
+        }
+        ImGui::Checkbox("LOD", &useLod);
+        if (useLod) {
+            ImGui::SliderInt("Far every", &lodFarInterval, 1, 16, "%d ticks");
+            ImGui::SliderInt("Hidden every", &lodHiddenInterval, 1, 16, "%d ticks");
+            ImGui::Text("Stepped %u of %u boids", simulation.steeredBoids(), nBoids);
+        }
+        const NeighborListStats& neighborStats = simulation.neighborStats();
+        if (!useOctree && neighborSkin > 0.f && neighborStats.steps > 0) {
+            ImGui::Text("Lists rebuilt %lu of %lu ticks", neighborStats.rebuilds, neighborStats.steps);
+            ImGui::Text("Build time saved: %.1f ms", neighborStats.savedSeconds() * 1e3);
+        }
+    }
+    // the gpu backend keeps its state on the gpu, so it does not record
+    if (!replaying && !gpuFlock) {
+        if (ImGui::Button(simulation.isRecording() ? "Stop Recording" : "Record", ImVec2(-1, 20))) {
+            if (simulation.isRecording()) {
+                simulation.stopRecording();
+            } else {
+                simulation.startRecording(recordingPath(), seed);
+            }
+        }
+        if (simulation.isRecording()) {
+            ImGui::Text("%lu frames, %lu dropped", (unsigned long)simulation.recordedFrames(), (unsigned long)simulation.droppedFrames());
+        }
+    }
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui::PushFont(fontTitle);
+    ImGui::Text("Profiling:");
+    ImGui::PopFont();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui_ProfilerPanel();
+    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+    ImGui_RenderStatsPanel();
+    ImGui::End();
 }
 
-void updateBoids(std::vector<glm::vec3> &boidPositions, std::vector<glm::vec3> &boidVelocities, float dt) {
-    for (unsigned int i = 0; i < boidPositions.size(); i++) {
-        glm::vec3 acceleration = boidBehavior(i, boidPositions, boidVelocities);
-        boidVelocities[i] += acceleration / (separationValue + cohesionValue + alignmentValue);
-
-        if (glm::length(boidVelocities[i]) > maxSpeed) {
-            boidVelocities[i] /= glm::length(boidVelocities[i]);
+int main(int argc, char** argv) {
+    std::chrono::steady_clock::time_point startup = std::chrono::steady_clock::now();
+
+    // command line
+    unsigned int validateSteps = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replaying = replay.open(argv[++i]);
+            if (!replaying) return 1;
+        } else if (arg == "--backend" && i + 1 < argc && (std::string(argv[i + 1]) == "cpu" || std::string(argv[i + 1]) == "gpu")) {
+            gpuBackend = std::string(argv[++i]) == "gpu";
+        } else if (arg == "--validate" && i + 1 < argc) {
+            validateSteps = std::atoi(argv[++i]);
+            gpuBackend = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "--render-log" && i + 1 < argc) {
+            renderLogPath = argv[++i];
+        } else if (arg == "--shader-cache" && i + 1 < argc) {
+            shaderCachePath = argv[++i];
+        } else if (arg == "--no-shader-cache") {
+            shaderCachePath.clear();
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (arg == "--size" && i + 1 < argc && std::sscanf(argv[i + 1], "%ux%u", &captureWidth, &captureHeight) == 2) {
+            i++;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            captureFrames = std::atoi(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            captureFps = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--replay FILE] [--backend cpu|gpu] [--validate STEPS] [--workers N] [--render-log FILE]"
+                      << " [--shader-cache DIR | --no-shader-cache]"
+                      << " [--capture FILE.y4m|FILE.ppm|- [--size WxH] [--frames N] [--fps N]]" << std::endl;
+            return 1;
         }
+    }
+    bool capturing = !capturePath.empty();
+    perceptionRadius = std::min(perceptionRadius, maxPerception());
+
+    // set opengl context, compute shaders need 4.3
+    GLFWwindow* window = nullptr;
+    HeadlessContext headless;
+    GLADloadproc loader = HeadlessContext::loader();
+    if (capturing) {
+        if (!headless.create(gpuBackend ? 4 : 3, 3)) return 1;
+    } else {
+        assert(glfwInit());
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, gpuBackend ? 4 : 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_SAMPLES, 4);
+
+        // creating window
+        window = glfwCreateWindow(windowWidth, windowHeight, "OpenGL - Boids", NULL, NULL);
+        assert(window);
+        glfwMakeContextCurrent(window);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_FALSE);
+        glfwSetWindowAttrib(window, GLFW_MAXIMIZED, GLFW_FALSE);
+
+        // load glad
+        loader = (GLADloadproc)glfwGetProcAddress;
+        assert(gladLoadGLLoader(loader));
+    }
+    if (gpuBackend && !GLCompute::load(loader)) {
+        if (window) glfwDestroyWindow(window);
+        if (window) glfwTerminate();
+        return 1;
+    }
+    ProgramCache::load(loader, shaderCachePath);
+    double contextSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startup).count();
+
+    // compare the backends and quit, works on llvmpipe without a gpu
+    if (validateSteps > 0) {
+        int status = validateGpuBackend(validateSteps);
+        if (window) glfwDestroyWindow(window);
+        if (window) glfwTerminate();
+        return status;
+    }
 
-        // check if boids go out of the cube, if so wrap them to the other side
-        boidPositions[i] += boidVelocities[i] * dt;
-        if (boidPositions[i].x < -25.f) boidPositions[i].x = 25.f;
-        if (boidPositions[i].y < -25.f) boidPositions[i].y = 25.f;
-        if (boidPositions[i].z < -25.f) boidPositions[i].z = 25.f;
-        if (boidPositions[i].x > +25.f) boidPositions[i].x = -25.f;
-        if (boidPositions[i].y > +25.f) boidPositions[i].y = -25.f;
-        if (boidPositions[i].z > +25.f) boidPositions[i].z = -25.f;
+    // the scene goes to the capture framebuffer instead of a window
+    FrameCapture capture;
+    unsigned int viewportWidth = windowWidth - menuWidth;
+    unsigned int viewportHeight = windowHeight;
+    if (capturing) {
+        if (!capture.open(capturePath, captureWidth, captureHeight, captureFps)) return 1;
+        capture.bind();
+        viewportWidth = captureWidth;
+        viewportHeight = captureHeight;
     }
-}
 
-int main() {
-    // set opengl context
-    assert(glfwInit());
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
-
-    // creating window
-    GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "OpenGL - Boids", NULL, NULL);
-    assert(window);
-    glfwMakeContextCurrent(window);
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_FALSE);
-    glfwSetWindowAttrib(window, GLFW_MAXIMIZED, GLFW_FALSE);
-
-    // load glad
-    assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress));
+    if (!renderLogPath.empty() && !RenderStats::startLog(renderLogPath)) return 1;
 
     // opengl settings
     glEnable(GL_MULTISAMPLE);
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
-    glViewport(0, 0, windowWidth - menuWidth, windowHeight);
+    glViewport(0, 0, viewportWidth, viewportHeight);
 
     // setup dear imgui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
-    io.IniFilename = NULL;                                    // Disable .ini file creation
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
-
-    // imgui font settings
-    io.Fonts->AddFontFromFileTTF("resources/fonts/Roboto-Regular.ttf", 14.0f);
-    ImFont* fontTitle = io.Fonts->AddFontFromFileTTF("resources/fonts/Roboto-Regular.ttf", 16.0f);
-
-    // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init();
-    ImGui_UpdateStyle();
-    ImVec2 windowPos(windowWidth - menuWidth, 0);
-    ImVec2 windowSize(menuWidth, windowHeight);
+    ImFont* fontTitle = nullptr;
+    if (window) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = NULL;                                    // Disable .ini file creation
+        io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+        io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+        // imgui font settings
+        io.Fonts->AddFontFromFileTTF("resources/fonts/Roboto-Regular.ttf", 14.0f);
+        fontTitle = io.Fonts->AddFontFromFileTTF("resources/fonts/Roboto-Regular.ttf", 16.0f);
+
+        // Setup Platform/Renderer backends
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init();
+        ImGui_UpdateStyle();
+    }
 
     // opengl scope
     {
@@ -209,103 +499,88 @@ int main() {
         };
 
         Shader shader("resources/shaders/main.vs", "resources/shaders/main.fs");
-        Mesh bird(vertices, indices);
+        Shader birdShader("resources/shaders/instanced.vs", "resources/shaders/main.fs");
+        Shader circleShader("resources/shaders/circles.vs", "resources/shaders/main.fs");
+        Shader gridShader("resources/shaders/grid.vs", "resources/shaders/grid.fs");
+        UniformBuffer cameraBuffer(0, sizeof(CameraBlock));
+        shader.bindUniformBlock("Camera", cameraBuffer.getBinding());
+        birdShader.bindUniformBlock("Camera", cameraBuffer.getBinding());
+        circleShader.bindUniformBlock("Camera", cameraBuffer.getBinding());
+        gridShader.bindUniformBlock("Camera", cameraBuffer.getBinding());
+
+        // uniform handles used every frame
+        Shader::Uniform<glm::mat4> modelUniform = shader.getUniform<glm::mat4>("model");
+        Shader::Uniform<glm::vec3> colorUniform = shader.getUniform<glm::vec3>("color");
+        Shader::Uniform<glm::vec3> birdColorUniform = birdShader.getUniform<glm::vec3>("color");
+        Shader::Uniform<glm::vec3> circleColorUniform = circleShader.getUniform<glm::vec3>("color");
+        Shader::Uniform<float> circleRadiusUniform = circleShader.getUniform<float>("radius");
+        Shader::Uniform<glm::mat4> gridModelUniform = gridShader.getUniform<glm::mat4>("model");
+        Shader::Uniform<glm::vec3> gridColorUniform = gridShader.getUniform<glm::vec3>("color");
+        Shader::Uniform<float> gridCellUniform = gridShader.getUniform<float>("cellSize");
+        Shader::Uniform<float> gridHalfSizeUniform = gridShader.getUniform<float>("halfSize");
+
+        // all static geometry shares one buffer, declared first so it
+        // outlives the meshes drawn from it
+        MeshArena arena;
+        InstancedMesh bird(arena, std::move(vertices), std::move(indices), 6);
+        // unit circle drawn three times per boid, reads the positions of
+        // whatever the birds were drawn from
+        InstancedMesh circles(arena, Primitives::circleVertices(1.f, 48), 3, 3);
 
         // get grid points
-        std::shared_ptr<Mesh> grid = Visualization::halfCubeGrid(space, grids);
-        std::shared_ptr<Mesh> cube = Visualization::halfCube(grids * space);
-        std::shared_ptr<Mesh> cubeBorders = Visualization::halfCubeBorders(grids * space);
+        std::shared_ptr<Mesh> grid = Visualization::halfCubeGrid(arena, space, grids);
+        std::shared_ptr<Mesh> cube = Visualization::halfCube(arena, grids * space);
+        std::shared_ptr<Mesh> cubeBorders = Visualization::halfCubeBorders(arena, grids * space);
+        arena.upload();
 
         // perspective matrices
-        glm::mat4 model = glm::mat4(1.0);
-        glm::mat4 projection = glm::perspective(glm::radians(40.0f), (float)(windowWidth - menuWidth) / windowHeight, 0.1f, 250.0f);
-
-        // get circle points
-        std::shared_ptr<Mesh> circle = Primitives::circle(0.3536, 30);
-        std::shared_ptr<Mesh> neighborhood = Primitives::circle(perceptionRadius, 100);
-
-        // generate random boids
-        generateBoids();
-
-        while (!glfwWindowShouldClose(window)) {
-            // imgui
-            ImGui_ImplOpenGL3_NewFrame();
-            ImGui_ImplGlfw_NewFrame();
-            ImGui::NewFrame();
-
-            // imgui window
-            ImGui::SetNextWindowPos(windowPos, ImGuiCond_Appearing);
-            ImGui::SetNextWindowSize(windowSize, ImGuiCond_Appearing);
-            ImGui::Begin("Simulation Settings", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
-            ImGui::TextWrapped("Welcome to Flocking Simulation! Use these controls to adjust visualization settings and simulation parameters.");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Separator();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::PushFont(fontTitle);
-            ImGui::Text("Visualization:");
-            ImGui::PopFont();
-            ImGui::TextWrapped("Setting what is being rendered.");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::SliderFloat("Altitude", &phi, 0.0f, 90.0f, "%.4f");
-            ImGui::SliderFloat("Azimuth", &theta, 0.0f, 360.0f, "%.4f");
-            ImGui::SliderFloat("Radius", &radius, 0.1f, 200.0f, "%.2f");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Columns(2, "drawingFunctions", false);
-            ImGui::Checkbox("Collision Region", &drawCollisionRegion);
-            ImGui::Checkbox("Percep. Region", &drawNeighborhood); ImGui::NextColumn();
-            ImGui::Checkbox("Cube Background", &drawBox);
-            ImGui::Checkbox("Cube Grid", &drawGrid);
-            ImGui::Columns(1);
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Separator();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::PushFont(fontTitle);
-            ImGui::Text("Behavior:");
-            ImGui::PopFont();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::TextWrapped("Flocking behaviors constant values.");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::SliderFloat("Alignment", &alignmentValue, 0.0f, 1.0f, "%.4f");
-            ImGui::SliderFloat("Cohesion", &cohesionValue, 0.0f, 1.0f, "%.4f");
-            ImGui::SliderFloat("Separation", &separationValue, 0.0f, 1.0f, "%.4f");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Separator();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::PushFont(fontTitle);
-            ImGui::Text("Boid:");
-            ImGui::PopFont();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::TextWrapped("Settings for an individual boid.");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::SliderFloat("Perception", &perceptionRadius, boidSize, 20*boidSize, "%.4f");
-            ImGui::SliderFloat("Max. Speed", &maxSpeed, 0, 100, "%.2f");
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Separator();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::PushFont(fontTitle);
-            ImGui::Text("Simulation:");
-            ImGui::PopFont();
-            ImGui::Dummy(ImVec2(0.0f, 5.0f));
-            ImGui::Columns(3, "simulationStatus", false);
-            if (ImGui::Button("Stop", ImVec2(75, 20))) {
-                running = false;
+        glm::mat4 projection = glm::perspective(glm::radians(40.0f), (float)viewportWidth / viewportHeight, 0.1f, 250.0f);
+
+        // generate random boids and start stepping them, unless replaying
+        SimulationThread simulation(flockParameters(), tickRate, timeScale, 25.f, replaying || gpuBackend ? 0 : workers);
+        FlockParameters lastParameters = flockParameters();
+        simulation.setReorderInterval(reorderInterval);
+        simulation.setNeighborSkin(neighborSkin);
+        simulation.setOctree(useOctree, openingAngle);
+        simulation.setCompact(useCompact);
+        LodSettings lastLod;
+        std::unique_ptr<GpuFlock> gpuFlock;
+        double gpuTime = 0.0;
+        // capture steps the flock itself, a fixed number of ticks per frame
+        double captureTime = 0.0;
+        if (!replaying) {
+            if (gpuBackend) {
+                gpuFlock = std::make_unique<GpuFlock>(25.f);
+            } else if (!capturing) {
+                simulation.start();
             }
-            ImGui::NextColumn();
-            if (ImGui::Button("Play", ImVec2(75, 20))) {
-                running = true;
-            }
-            ImGui::NextColumn();
-            if (ImGui::Button("Restart", ImVec2(75, 20))) {
-                generator = std::mt19937(seed);
-                generateBoids();
-
+            restartFlock(simulation, gpuFlock.get());
+        }
+        std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+
+        unsigned int capturedFrames = 0;
+        bool startupReported = false;
+#ifdef SHADER_HOT_RELOAD
+        double lastReload = 0.0;
+#endif
+        while (capturing ? capturedFrames < captureFrames : !glfwWindowShouldClose(window)) {
+            Profiler::nextFrame();
+            RenderStats::beginFrame();
+            PROFILE_SCOPE(Profiler::Frame);
+
+            // settings panel, none when capturing
+            if (window) {
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+                settingsWindow(simulation, gpuFlock.get(), fontTitle);
             }
-            ImGui::End();
 
-            // update neighborhood size
-            if (lastPerceptionRadius != perceptionRadius) {
-                lastPerceptionRadius = perceptionRadius;
-                neighborhood = Primitives::circle(perceptionRadius, 100);
+            // forward slider changes to the simulation thread
+            FlockParameters parameters = flockParameters();
+            if (std::memcmp(&parameters, &lastParameters, sizeof(FlockParameters)) != 0) {
+                lastParameters = parameters;
+                simulation.setParameters(parameters);
             }
 
             // update camera angles
@@ -313,93 +588,208 @@ int main() {
             camera.setTheta(theta);
             camera.setPhi(phi);
 
-            // simulation
-            float currentFrame = static_cast<float>(glfwGetTime()/2);
-            deltaTime = currentFrame - lastFrame;
-            lastFrame = currentFrame;
-            if (running) {
-                updateBoids(boidPositions, boidVelocities, deltaTime);
+            // simulation runs on its own thread, take the latest state
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            double frameTime = std::chrono::duration<double>(now - lastFrame).count();
+            lastFrame = now;
+            // captured videos advance at their frame rate, however slow the rendering
+            if (capturing) frameTime = 1.0 / captureFps;
+            BoidView boids;
+            if (replaying) {
+                // advance through the recording at the pace it was recorded
+                double recordedStep = replay.getHeader().dt / timeScale;
+                if (running && recordedStep > 0.0) {
+                    replayTime += frameTime;
+                    while (replayTime >= recordedStep && replayFrame + 1 < static_cast<int>(replay.frameCount())) {
+                        replayTime -= recordedStep;
+                        replayFrame++;
+                    }
+                    if (replayFrame + 1 >= static_cast<int>(replay.frameCount())) replayTime = 0.0;
+                }
+                if (replay.frameCount() > 0) {
+                    boids = replay.frame(replayFrame);
+                    replay.prefetch(replayFrame + 1);
+                }
+            } else if (gpuFlock) {
+                // fixed rate ticks on the render thread, the state never
+                // leaves the gpu
+                double period = 1.0 / tickRate;
+                if (running) {
+                    gpuTime += frameTime;
+                    RenderStats::beginPass(RenderStats::GpuStep);
+                    for (unsigned int steps = 0; gpuTime >= period && steps < MAX_GPU_STEPS; steps++) {
+                        gpuFlock->update(flockParameters(), timeScale / tickRate);
+                        gpuTime -= period;
+                    }
+                    RenderStats::endPass();
+                    if (gpuTime >= period) gpuTime = 0.0;
+                }
+            } else if (capturing) {
+                // whole ticks only, so each frame shows a tick as it was stepped
+                double period = 1.0 / tickRate;
+                unsigned int ticks = 0;
+                if (running) {
+                    captureTime += frameTime;
+                    for (; captureTime >= period; captureTime -= period) ticks++;
+                }
+                simulation.advance(ticks);
+                boids = simulation.latest().view();
+            } else {
+                boids = simulation.interpolated(now).view();
             }
             glm::mat4 view = camera.getViewMatrix();
 
+            // the lod follows the camera, boids beyond the orbit center are far
+            if (!replaying && !gpuFlock && workers == 0) {
+                LodSettings lod;
+                lod.enabled = useLod;
+                lod.eye = glm::vec3(glm::inverse(view)[3]);
+                lod.viewProjection = projection * view;
+                lod.farDistance = radius;
+                lod.farInterval = lodFarInterval;
+                lod.hiddenInterval = lodHiddenInterval;
+                if (lod.enabled != lastLod.enabled || (lod.enabled && (lod.viewProjection != lastLod.viewProjection ||
+                    lod.farDistance != lastLod.farDistance || lod.farInterval != lastLod.farInterval || lod.hiddenInterval != lastLod.hiddenInterval))) {
+                    lastLod = lod;
+                    simulation.setLod(lod);
+                }
+            }
+
             // set uniforms
+            cameraBuffer.update(CameraBlock{view, projection});
             shader.use();
-            shader.uniform("projection", projection);
-            shader.uniform("view", view);
 
             // render phase
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            // draw grid
-            glm::mat4 cubeModel = glm::mat4(1.0);
-            float rotatedTheta = glm::radians(int(camera.getTheta() / 90)* 90.0f);
-            cubeModel = glm::rotate(cubeModel, rotatedTheta, UP);
-
-            glDepthMask(GL_FALSE);
-            if (drawBox) {
-                shader.uniform("model", cubeModel);
-                shader.uniform("color", 0.8f, 0.8f, 0.85f);
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-                cube->draw();
-                shader.uniform("color", 0.f, 0.f, 0.f);
-                cubeBorders->draw();
-            }
-            if (drawGrid) {
-                shader.uniform("model", cubeModel);
-                shader.uniform("color", 0.f, 0.f, 0.f);
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                grid->draw();
+            {
+                PROFILE_SCOPE(Profiler::RenderScene);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                // draw grid
+                glm::mat4 cubeModel = glm::mat4(1.0);
+                float rotatedTheta = glm::radians(int(camera.getTheta() / 90)* 90.0f);
+                cubeModel = glm::rotate(cubeModel, rotatedTheta, UP);
+
+                glDepthMask(GL_FALSE);
+                if (drawBox) {
+                    RenderPassScope pass(RenderStats::Cube);
+                    shader.set(modelUniform, cubeModel);
+                    shader.set(colorUniform, glm::vec3(0.8f, 0.8f, 0.85f));
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                    cube->draw();
+                    shader.set(colorUniform, glm::vec3(0.f, 0.f, 0.f));
+                    cubeBorders->draw();
+                }
+                if (drawGrid && shaderGrid) {
+                    // the cube's three faces, blended over whatever is behind
+                    RenderPassScope pass(RenderStats::Grid);
+                    gridShader.use();
+                    gridShader.set(gridModelUniform, cubeModel);
+                    gridShader.set(gridColorUniform, glm::vec3(0.f, 0.f, 0.f));
+                    gridShader.set(gridCellUniform, space);
+                    gridShader.set(gridHalfSizeUniform, grids * space / 2.f);
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                    glEnable(GL_BLEND);
+                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                    cube->draw();
+                    glDisable(GL_BLEND);
+                } else if (drawGrid) {
+                    RenderPassScope pass(RenderStats::Grid);
+                    shader.set(modelUniform, cubeModel);
+                    shader.set(colorUniform, glm::vec3(0.f, 0.f, 0.f));
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+                    grid->draw();
+                }
+                glDepthMask(GL_TRUE);
             }
-            glDepthMask(GL_TRUE);
-
-            for (unsigned int i = 0; i < boidPositions.size(); i++) {
-                glm::mat4 rotated, tmp_model = glm::translate(model, boidPositions[i]);
-
-                if (drawCollisionRegion) {
-                    shader.uniform("color", 0.75f, 0.50f, 0.50f);
-                    circle->draw();
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, glm::vec3(1, 0, 0));
-                    shader.uniform("model", rotated);
-                    circle->draw();
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, UP);
-                    shader.uniform("model", rotated);
-                    circle->draw();
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, glm::vec3(0, 0, 1));
-                    shader.uniform("model", rotated);
-                    circle->draw();
+
+            // the flock and its per-boid overlays
+            {
+                PROFILE_SCOPE(Profiler::RenderBoids);
+                RenderStats::beginPass(RenderStats::Birds);
+                if (gpuFlock) {
+                    bird.bind(gpuFlock->getBuffer(), gpuFlock->getStride(), gpuFlock->size());
+                } else {
+                    const float* instances[] = {boids.x, boids.y, boids.z, boids.vx, boids.vy, boids.vz};
+                    bird.update(instances, boids.size());
+                }
+                birdShader.use();
+                birdShader.set(birdColorUniform, glm::vec3(0.f, 0.f, 0.f));
+                bird.drawInstanced();
+                RenderStats::endPass();
+
+                // one draw per kind of circle, three circles per boid
+                if (drawCollisionRegion || drawNeighborhood) {
+                    RenderPassScope pass(RenderStats::Overlays);
+                    if (gpuFlock) {
+                        circles.bind(gpuFlock->getBuffer(), gpuFlock->getStride(), gpuFlock->size());
+                    } else {
+                        circles.bind(bird.getInstanceBuffer(), bird.getStride(), boids.size());
+                    }
+                    circleShader.use();
+                    if (drawCollisionRegion) {
+                        circleShader.set(circleColorUniform, glm::vec3(0.75f, 0.50f, 0.50f));
+                        circleShader.set(circleRadiusUniform, boidSize);
+                        circles.drawInstanced();
+                    }
+                    if (drawNeighborhood) {
+                        circleShader.set(circleColorUniform, glm::vec3(0.5f, 0.5f, 0.75f));
+                        circleShader.set(circleRadiusUniform, perceptionRadius);
+                        circles.drawInstanced();
+                    }
                 }
+            }
+
+            // how long the first frame took, and how much of it was shaders
+            if (!startupReported) {
+                startupReported = true;
+                const ProgramCache::Stats& programs = ProgramCache::stats();
+                double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - startup).count();
+                std::fprintf(
+                    stderr, "first frame after %.1f ms: context %.1f ms, %u programs in %.1f ms (%u cached, %u compiled, %u rejected)\n",
+                    total * 1e3, contextSeconds * 1e3, programs.hits + programs.compiled, programs.seconds * 1e3,
+                    programs.hits, programs.compiled, programs.rejected
+                );
+            }
 
-                if (drawNeighborhood) {
-                    shader.uniform("color", 0.5f, 0.5f, 0.75f);
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, glm::vec3(1, 0, 0));
-                    shader.uniform("model", rotated);
-                    neighborhood->draw();
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, UP);
-                    shader.uniform("model", rotated);
-                    neighborhood->draw();
-                    rotated = glm::rotate(tmp_model, (float)M_PI/2, glm::vec3(0, 0, 1));
-                    shader.uniform("model", rotated);
-                    neighborhood->draw();
+#ifdef SHADER_HOT_RELOAD
+            // edited shader files are picked up twice a second
+            double elapsed = std::chrono::duration<double>(now - startup).count();
+            if (elapsed - lastReload >= 0.5) {
+                lastReload = elapsed;
+                for (Shader* program : {&shader, &birdShader, &circleShader, &gridShader}) {
+                    program->reload();
                 }
+            }
+#endif
 
-                // fix bird rotation
-                glm::vec3 v = boidVelocities[i];
-                tmp_model = glm::rotate(tmp_model, -atan2f(v.z, v.x), UP);
-                tmp_model = glm::rotate(tmp_model, atan2f(v.y, sqrtf(v.x*v.x+v.z*v.z)), glm::vec3(0, 0, 1));
-                shader.uniform("model", tmp_model);
-                shader.uniform("color", 0.f, 0.f, 0.f);
-                bird.draw();
+            // hand the frame to the capture, or show it
+            if (capturing) {
+                capture.capture();
+                capturedFrames++;
+                continue;
             }
 
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            {
+                PROFILE_SCOPE(Profiler::ImGuiPass);
+                RenderPassScope pass(RenderStats::Interface);
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
 
             // process screen
-            glfwSwapBuffers(window);
+            {
+                PROFILE_SCOPE(Profiler::SwapBuffers);
+                glfwSwapBuffers(window);
+            }
             glfwPollEvents();
         }
     }
 
+    RenderStats::stopLog();
+    if (capturing) {
+        return capture.close() ? 0 : 1;
+    }
+
     // glfw terminate
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
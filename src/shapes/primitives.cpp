@@ -2,7 +2,8 @@
 
 #include <cmath>
 
-std::shared_ptr<Mesh> Primitives::circle(float radius, unsigned int points) {
+// points of a circle in the xy plane, to be drawn as a line loop
+std::vector<float> Primitives::circleVertices(float radius, unsigned int points) {
     float deltaTheta = M_PI*2/points;
     std::vector<float> vertices;
 
@@ -12,5 +13,9 @@ std::shared_ptr<Mesh> Primitives::circle(float radius, unsigned int points) {
         vertices.push_back(0);
     }
 
-    return std::make_shared<Mesh>(vertices);
+    return vertices;
+}
+
+std::shared_ptr<Mesh> Primitives::circle(MeshArena& arena, float radius, unsigned int points) {
+    return std::make_shared<Mesh>(arena, circleVertices(radius, points));
 }
@@ -10,8 +10,9 @@
 
 class Primitives {
     public:
-        static std::shared_ptr<Mesh> circle(float radius, unsigned int points);
-        static std::shared_ptr<Mesh> grid(float size, unsigned int spaces);
+        static std::vector<float> circleVertices(float radius, unsigned int points);
+        static std::shared_ptr<Mesh> circle(MeshArena& arena, float radius, unsigned int points);
+        static std::shared_ptr<Mesh> grid(MeshArena& arena, float size, unsigned int spaces);
 };
 
 #endif  // CORE_PRIMITIVES_HPP_
@@ -1,7 +1,9 @@
 #include "shapes/visualization.hpp"
 
-std::shared_ptr<Mesh> Visualization::halfCubeGrid(float size, unsigned int spaces) {
+std::shared_ptr<Mesh> Visualization::halfCubeGrid(MeshArena& arena, float size, unsigned int spaces) {
+    // 3 planes of 4 points per cell column, xyz each
     std::vector<float> vertices;
+    vertices.reserve(static_cast<size_t>(spaces) * (spaces + 1) * 3 * 4 * 3);
     float points = spaces + 1;
     float offset = -(spaces/2.0)*size;
 
@@ -67,13 +69,13 @@ std::shared_ptr<Mesh> Visualization::halfCubeGrid(float size, unsigned int space
         }
     }
 
-    std::shared_ptr<Mesh> grid = std::make_shared<Mesh>(vertices);
+    std::shared_ptr<Mesh> grid = std::make_shared<Mesh>(arena, std::move(vertices));
     grid->setDrawMode(GL_LINES);
 
     return grid;
 }
 
-std::shared_ptr<Mesh> Visualization::halfCube(float size) {
+std::shared_ptr<Mesh> Visualization::halfCube(MeshArena& arena, float size) {
     // create vertices
     float w = size / 2.0f;
     std::vector<float> vertices = {
@@ -97,13 +99,13 @@ std::shared_ptr<Mesh> Visualization::halfCube(float size) {
         +w, -w - 0.01f, +w,
     };
 
-    std::shared_ptr<Mesh> cube = std::make_shared<Mesh>(vertices);
+    std::shared_ptr<Mesh> cube = std::make_shared<Mesh>(arena, std::move(vertices));
     cube->setDrawMode(GL_TRIANGLES);
 
     return cube;
 }
 
-std::shared_ptr<Mesh> Visualization::halfCubeBorders(float size) {
+std::shared_ptr<Mesh> Visualization::halfCubeBorders(MeshArena& arena, float size) {
     // create vertices
     float w = size / 2.0f;
     std::vector<float> vertices = {
@@ -127,7 +129,7 @@ std::shared_ptr<Mesh> Visualization::halfCubeBorders(float size) {
         -w, -w, -w,
     };
 
-    std::shared_ptr<Mesh> grid = std::make_shared<Mesh>(vertices);
+    std::shared_ptr<Mesh> grid = std::make_shared<Mesh>(arena, std::move(vertices));
     grid->setDrawMode(GL_LINES);
 
     return grid;
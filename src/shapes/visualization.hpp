@@ -7,9 +7,9 @@
 
 class Visualization {
     public:
-        static std::shared_ptr<Mesh> halfCube(float size);
-        static std::shared_ptr<Mesh> halfCubeGrid(float size, unsigned int spaces);
-        static std::shared_ptr<Mesh> halfCubeBorders(float size);
+        static std::shared_ptr<Mesh> halfCube(MeshArena& arena, float size);
+        static std::shared_ptr<Mesh> halfCubeGrid(MeshArena& arena, float size, unsigned int spaces);
+        static std::shared_ptr<Mesh> halfCubeBorders(MeshArena& arena, float size);
 };
 
 #endif  // SHAPES_VISUALIZATION_HPP_
\ No newline at end of file
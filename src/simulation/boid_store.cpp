@@ -0,0 +1,46 @@
+#include "simulation/boid_store.hpp"
+
+#include <cstring>
+
+// arrays start on their own cache line
+const unsigned int ALIGNMENT = 64;
+const unsigned int FLOATS_PER_LINE = ALIGNMENT / sizeof(float);
+
+BoidStore::BoidStore(const BoidStore& other) {
+    *this = other;
+}
+
+BoidStore& BoidStore::operator=(const BoidStore& other) {
+    if (this != &other) {
+        this->resize(other.count);
+        size_t bytes = sizeof(float) * other.count;
+        std::memcpy(this->x, other.x, bytes);
+        std::memcpy(this->y, other.y, bytes);
+        std::memcpy(this->z, other.z, bytes);
+        std::memcpy(this->vx, other.vx, bytes);
+        std::memcpy(this->vy, other.vy, bytes);
+        std::memcpy(this->vz, other.vz, bytes);
+    }
+    return *this;
+}
+
+void BoidStore::resize(unsigned int count) {
+    unsigned int stride = (count + PADDING + FLOATS_PER_LINE - 1) / FLOATS_PER_LINE * FLOATS_PER_LINE;
+
+    if (stride > this->stride || !this->storage) {
+        size_t bytes = 6 * sizeof(float) * stride;
+        this->storage.reset(static_cast<float*>(std::aligned_alloc(ALIGNMENT, bytes)));
+        std::memset(this->storage.get(), 0, bytes);
+        this->stride = stride;
+
+        float* base = this->storage.get();
+        this->x = base;
+        this->y = base + stride;
+        this->z = base + 2 * stride;
+        this->vx = base + 3 * stride;
+        this->vy = base + 4 * stride;
+        this->vz = base + 5 * stride;
+    }
+
+    this->count = count;
+}
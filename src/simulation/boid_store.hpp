@@ -0,0 +1,95 @@
+#ifndef SIMULATION_BOID_STORE_HPP_
+#define SIMULATION_BOID_STORE_HPP_
+
+#include "glm/glm.hpp"
+
+#include <cstdlib>
+#include <memory>
+
+// read-only view of structure-of-arrays boid state owned elsewhere (a
+// BoidStore, a snapshot, a memory-mapped recording)
+struct BoidView {
+    unsigned int count = 0;
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* z = nullptr;
+    const float* vx = nullptr;
+    const float* vy = nullptr;
+    const float* vz = nullptr;
+
+    unsigned int size() const { return count; }
+    glm::vec3 position(unsigned int i) const { return glm::vec3(x[i], y[i], z[i]); }
+    glm::vec3 velocity(unsigned int i) const { return glm::vec3(vx[i], vy[i], vz[i]); }
+};
+
+// structure-of-arrays boid state. each component lives in its own array,
+// aligned to a cache line and padded so vector kernels can always load a
+// full register past the last boid of any range.
+class BoidStore {
+    public:
+        // floats of padding kept after the last boid of every array
+        static const unsigned int PADDING = 8;
+
+    private:
+        struct Free {
+            void operator()(float* data) const { std::free(data); }
+        };
+
+        std::unique_ptr<float, Free> storage;
+        unsigned int count = 0;
+        unsigned int stride = 0;
+
+    public:
+        float* x = nullptr;
+        float* y = nullptr;
+        float* z = nullptr;
+        float* vx = nullptr;
+        float* vy = nullptr;
+        float* vz = nullptr;
+
+        BoidStore() = default;
+        BoidStore(const BoidStore& other);
+        BoidStore(BoidStore&& other) = default;
+        BoidStore& operator=(const BoidStore& other);
+        BoidStore& operator=(BoidStore&& other) = default;
+
+        // drops the current contents when the capacity has to grow
+        void resize(unsigned int count);
+        unsigned int size() const;
+
+        BoidView view() const;
+        glm::vec3 position(unsigned int i) const;
+        glm::vec3 velocity(unsigned int i) const;
+        void setPosition(unsigned int i, const glm::vec3& position);
+        void setVelocity(unsigned int i, const glm::vec3& velocity);
+};
+
+inline unsigned int BoidStore::size() const {
+    return this->count;
+}
+
+inline BoidView BoidStore::view() const {
+    return {this->count, this->x, this->y, this->z, this->vx, this->vy, this->vz};
+}
+
+inline glm::vec3 BoidStore::position(unsigned int i) const {
+    return glm::vec3(this->x[i], this->y[i], this->z[i]);
+}
+
+inline glm::vec3 BoidStore::velocity(unsigned int i) const {
+    return glm::vec3(this->vx[i], this->vy[i], this->vz[i]);
+}
+
+inline void BoidStore::setPosition(unsigned int i, const glm::vec3& position) {
+    this->x[i] = position.x;
+    this->y[i] = position.y;
+    this->z[i] = position.z;
+}
+
+inline void BoidStore::setVelocity(unsigned int i, const glm::vec3& velocity) {
+    this->vx[i] = velocity.x;
+    this->vy[i] = velocity.y;
+    this->vz[i] = velocity.z;
+}
+
+#endif  // SIMULATION_BOID_STORE_HPP_
@@ -0,0 +1,43 @@
+#include "simulation/compact_store.hpp"
+
+#include <cfloat>
+#include <cstring>
+
+// arrays start on their own cache line
+const unsigned int ALIGNMENT = 64;
+const unsigned int VALUES_PER_LINE = ALIGNMENT / sizeof(int16_t);
+
+void CompactStore::resize(unsigned int count) {
+    unsigned int stride = (count + PADDING + VALUES_PER_LINE - 1) / VALUES_PER_LINE * VALUES_PER_LINE;
+
+    if (stride > this->stride || !this->storage) {
+        size_t bytes = 6 * sizeof(int16_t) * stride;
+        this->storage.reset(static_cast<int16_t*>(std::aligned_alloc(ALIGNMENT, bytes)));
+        std::memset(this->storage.get(), 0, bytes);
+        this->stride = stride;
+
+        int16_t* base = this->storage.get();
+        this->x = base;
+        this->y = base + stride;
+        this->z = base + 2 * stride;
+        this->vx = base + 3 * stride;
+        this->vy = base + 4 * stride;
+        this->vz = base + 5 * stride;
+    }
+
+    this->count = count;
+}
+
+void CompactStore::setRanges(float bound, float velocityRange) {
+    this->positionStep = bound / LIMIT;
+    this->velocityStep = velocityRange / LIMIT;
+}
+
+// half a step of rounding, plus the float rounding of encode and decode
+float CompactStore::positionError() const {
+    return (0.5f + LIMIT * FLT_EPSILON) * this->positionStep;
+}
+
+float CompactStore::velocityError() const {
+    return (0.5f + LIMIT * FLT_EPSILON) * this->velocityStep;
+}
@@ -0,0 +1,106 @@
+#ifndef SIMULATION_COMPACT_STORE_HPP_
+#define SIMULATION_COMPACT_STORE_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+// boid state quantized to 16-bit fixed point, 12 bytes per boid instead of
+// 24. positions are stored relative to the cube bound and velocities
+// relative to a velocity range, both symmetric around zero:
+//
+//     x  = qx * positionStep,  positionStep = bound / 32767
+//     vx = qvx * velocityStep, velocityStep = velocityRange / 32767
+//
+// encoding rounds to nearest, so every decoded component is off by at most
+// half a step (plus float rounding, see positionError()): bound / 65534,
+// 3.8e-4 for the default bound of 25, and velocityRange / 65534. values
+// beyond the ranges are clamped to them.
+// arrays are laid out like BoidStore, aligned and padded for vector loads.
+class CompactStore {
+    public:
+        // int16 values of padding kept after the last boid of every array
+        static const unsigned int PADDING = 16;
+        static const int LIMIT = 32767;
+
+    private:
+        struct Free {
+            void operator()(int16_t* data) const { std::free(data); }
+        };
+
+        std::unique_ptr<int16_t, Free> storage;
+        unsigned int count = 0;
+        unsigned int stride = 0;
+        float positionStep = 0.f;
+        float velocityStep = 0.f;
+
+        static int16_t quantize(float value, float step);
+
+    public:
+        int16_t* x = nullptr;
+        int16_t* y = nullptr;
+        int16_t* z = nullptr;
+        int16_t* vx = nullptr;
+        int16_t* vy = nullptr;
+        int16_t* vz = nullptr;
+
+        // drops the current contents when the capacity has to grow
+        void resize(unsigned int count);
+        unsigned int size() const;
+
+        // scales of the values encoded from now on
+        void setRanges(float bound, float velocityRange);
+        float getPositionStep() const;
+        float getVelocityStep() const;
+
+        // largest difference between a component and its decoded value
+        float positionError() const;
+        float velocityError() const;
+
+        void encode(unsigned int slot, const BoidStore& boids, unsigned int i);
+        glm::vec3 position(unsigned int i) const;
+        glm::vec3 velocity(unsigned int i) const;
+};
+
+inline unsigned int CompactStore::size() const {
+    return this->count;
+}
+
+inline float CompactStore::getPositionStep() const {
+    return this->positionStep;
+}
+
+inline float CompactStore::getVelocityStep() const {
+    return this->velocityStep;
+}
+
+inline int16_t CompactStore::quantize(float value, float step) {
+    float q = std::nearbyint(value / step);
+    if (q > LIMIT) q = LIMIT;
+    if (q < -LIMIT) q = -LIMIT;
+    return static_cast<int16_t>(q);
+}
+
+inline void CompactStore::encode(unsigned int slot, const BoidStore& boids, unsigned int i) {
+    this->x[slot] = quantize(boids.x[i], this->positionStep);
+    this->y[slot] = quantize(boids.y[i], this->positionStep);
+    this->z[slot] = quantize(boids.z[i], this->positionStep);
+    this->vx[slot] = quantize(boids.vx[i], this->velocityStep);
+    this->vy[slot] = quantize(boids.vy[i], this->velocityStep);
+    this->vz[slot] = quantize(boids.vz[i], this->velocityStep);
+}
+
+inline glm::vec3 CompactStore::position(unsigned int i) const {
+    return glm::vec3(this->x[i], this->y[i], this->z[i]) * this->positionStep;
+}
+
+inline glm::vec3 CompactStore::velocity(unsigned int i) const {
+    return glm::vec3(this->vx[i], this->vy[i], this->vz[i]) * this->velocityStep;
+}
+
+#endif  // SIMULATION_COMPACT_STORE_HPP_
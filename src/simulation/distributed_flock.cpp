@@ -0,0 +1,443 @@
+#include "simulation/distributed_flock.hpp"
+
+#include "simulation/thread_pool.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+
+static_assert(sizeof(BoidRecord) == 28, "boid record layout changed");
+
+namespace {
+    struct ControlMessage {
+        enum Type : uint32_t { Reset, Step, Gather, Quit } type;
+        uint32_t count;
+        FlockParameters params;
+        float dt;
+    };
+
+    bool sendAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            bytes += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    bool receiveAll(int fd, void* data, size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t received = recv(fd, bytes, size, 0);
+            if (received < 0 && errno == EINTR) continue;
+            if (received <= 0) return false;
+            bytes += received;
+            size -= received;
+        }
+        return true;
+    }
+
+    bool sendRecords(int fd, const std::vector<BoidRecord>& records) {
+        uint32_t count = records.size();
+        return sendAll(fd, &count, sizeof(count)) && sendAll(fd, records.data(), count * sizeof(BoidRecord));
+    }
+
+    bool receiveRecords(int fd, std::vector<BoidRecord>& records) {
+        uint32_t count = 0;
+        if (!receiveAll(fd, &count, sizeof(count))) return false;
+        records.resize(count);
+        return receiveAll(fd, records.data(), count * sizeof(BoidRecord));
+    }
+
+    // one direction pair of a neighbor link: a count followed by records
+    // each way
+    struct Transfer {
+        int fd;
+        uint32_t outCount;
+        const BoidRecord* out;
+        size_t sent = 0;
+        uint32_t inCount = 0;
+        std::vector<BoidRecord>* in;
+        size_t received = 0;
+
+        size_t outSize() const { return sizeof(uint32_t) + outCount * sizeof(BoidRecord); }
+        size_t inSize() const { return sizeof(uint32_t) + inCount * sizeof(BoidRecord); }
+        bool sending() const { return this->sent < this->outSize(); }
+        bool receiving() const { return this->received < sizeof(uint32_t) || this->received < this->inSize(); }
+    };
+
+    // sends out[s] over sockets[s] while reading in[s] from it. every worker
+    // of the ring talks to both neighbors at once, so no order of sends can
+    // deadlock on full socket buffers.
+    bool exchange(const int sockets[2], const std::vector<BoidRecord> out[2], std::vector<BoidRecord> in[2]) {
+        Transfer transfers[2] = {
+            {sockets[0], static_cast<uint32_t>(out[0].size()), out[0].data(), 0, 0, &in[0], 0},
+            {sockets[1], static_cast<uint32_t>(out[1].size()), out[1].data(), 0, 0, &in[1], 0},
+        };
+
+        while (true) {
+            pollfd fds[2];
+            bool pending = false;
+            for (unsigned int s = 0; s < 2; s++) {
+                fds[s].fd = transfers[s].fd;
+                fds[s].events = (transfers[s].sending() ? POLLOUT : 0) | (transfers[s].receiving() ? POLLIN : 0);
+                fds[s].revents = 0;
+                pending |= fds[s].events != 0;
+            }
+            if (!pending) return true;
+
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+
+            for (unsigned int s = 0; s < 2; s++) {
+                Transfer& t = transfers[s];
+                if (fds[s].revents & (POLLERR | POLLNVAL)) return false;
+
+                if ((fds[s].revents & POLLOUT) && t.sending()) {
+                    const char* data = t.sent < sizeof(uint32_t)
+                        ? reinterpret_cast<const char*>(&t.outCount) + t.sent
+                        : reinterpret_cast<const char*>(t.out) + (t.sent - sizeof(uint32_t));
+                    size_t size = t.sent < sizeof(uint32_t) ? sizeof(uint32_t) - t.sent : t.outSize() - t.sent;
+                    ssize_t sent = send(t.fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+                    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+                    if (sent > 0) t.sent += sent;
+                }
+
+                if ((fds[s].revents & (POLLIN | POLLHUP)) && t.receiving()) {
+                    char* data;
+                    size_t size;
+                    if (t.received < sizeof(uint32_t)) {
+                        data = reinterpret_cast<char*>(&t.inCount) + t.received;
+                        size = sizeof(uint32_t) - t.received;
+                    } else {
+                        data = reinterpret_cast<char*>(t.in->data()) + (t.received - sizeof(uint32_t));
+                        size = t.inSize() - t.received;
+                    }
+                    ssize_t received = recv(t.fd, data, size, MSG_DONTWAIT);
+                    if (received == 0) return false;
+                    if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+                    if (received > 0) {
+                        t.received += received;
+                        if (t.received == sizeof(uint32_t)) t.in->resize(t.inCount);
+                    }
+                }
+            }
+        }
+    }
+
+    class SlabWorker {
+        private:
+            unsigned int index;
+            unsigned int workers;
+            float bound;
+            float width;
+            float x0;
+            float x1;
+            int control;
+            // left then right neighbor, -1 without neighbors
+            int links[2];
+
+            ThreadPool pool;
+            Flock flock;
+            std::vector<BoidRecord> owned;
+            std::vector<BoidRecord> out[2];
+            std::vector<BoidRecord> in[2];
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> velocities;
+
+            unsigned int owner(float x) const {
+                int slab = static_cast<int>(std::floor((x + this->bound) / this->width));
+                return std::clamp(slab, 0, static_cast<int>(this->workers) - 1);
+            }
+
+            bool step(const FlockParameters& params, float dt);
+
+        public:
+            SlabWorker(unsigned int index, unsigned int workers, unsigned int threads, float bound, int control, int left, int right)
+                : index(index), workers(workers), bound(bound), width(2.f * bound / workers),
+                  x0(-bound + index * width), x1(-bound + (index + 1) * width),
+                  control(control), links{left, right}, pool(threads), flock(pool, bound) {
+            }
+
+            void run();
+    };
+
+    bool SlabWorker::step(const FlockParameters& params, float dt) {
+        float radius = params.perceptionRadius;
+        bool linked = this->links[0] >= 0;
+
+        // halo: owned boids a neighbor may see, never across the wrap-around border
+        this->out[0].clear();
+        this->out[1].clear();
+        for (const BoidRecord& boid : this->owned) {
+            if (this->index > 0 && boid.x < this->x0 + radius) this->out[0].push_back(boid);
+            if (this->index + 1 < this->workers && boid.x >= this->x1 - radius) this->out[1].push_back(boid);
+        }
+        this->in[0].clear();
+        this->in[1].clear();
+        if (linked && !exchange(this->links, this->out, this->in)) return false;
+
+        // step owned and halo boids together, keep only the owned ones
+        this->positions.clear();
+        this->velocities.clear();
+        for (const std::vector<BoidRecord>* part : {&this->owned, &this->in[0], &this->in[1]}) {
+            for (const BoidRecord& boid : *part) {
+                this->positions.push_back(glm::vec3(boid.x, boid.y, boid.z));
+                this->velocities.push_back(glm::vec3(boid.vx, boid.vy, boid.vz));
+            }
+        }
+        this->flock.reset(this->positions, this->velocities);
+        this->flock.update(params, dt);
+
+        const BoidStore& boids = this->flock.getOrdered();
+        for (unsigned int k = 0; k < this->owned.size(); k++) {
+            BoidRecord& boid = this->owned[k];
+            boid.x = boids.x[k];
+            boid.y = boids.y[k];
+            boid.z = boids.z[k];
+            boid.vx = boids.vx[k];
+            boid.vy = boids.vy[k];
+            boid.vz = boids.vz[k];
+        }
+
+        // migration: boids that left the slab go to the neighbor owning them,
+        // steps never move a boid further than one slab (see update)
+        // wrapped boids reach the other end of the cube through the ring
+        this->out[0].clear();
+        this->out[1].clear();
+        unsigned int right = (this->index + 1) % this->workers;
+        unsigned int kept = 0;
+        for (const BoidRecord& boid : this->owned) {
+            unsigned int slab = this->owner(boid.x);
+            if (slab == this->index || !linked) {
+                this->owned[kept++] = boid;
+            } else {
+                this->out[slab == right ? 1 : 0].push_back(boid);
+            }
+        }
+        this->owned.resize(kept);
+
+        this->in[0].clear();
+        this->in[1].clear();
+        if (linked && !exchange(this->links, this->out, this->in)) return false;
+        this->owned.insert(this->owned.end(), this->in[0].begin(), this->in[0].end());
+        this->owned.insert(this->owned.end(), this->in[1].begin(), this->in[1].end());
+        return true;
+    }
+
+    void SlabWorker::run() {
+        ControlMessage message;
+        while (receiveAll(this->control, &message, sizeof(message))) {
+            uint32_t owned = 0;
+            switch (message.type) {
+                case ControlMessage::Reset:
+                    this->owned.resize(message.count);
+                    if (!receiveAll(this->control, this->owned.data(), message.count * sizeof(BoidRecord))) return;
+                    owned = this->owned.size();
+                    if (!sendAll(this->control, &owned, sizeof(owned))) return;
+                    break;
+                case ControlMessage::Step:
+                    if (!this->step(message.params, message.dt)) return;
+                    owned = this->owned.size();
+                    if (!sendAll(this->control, &owned, sizeof(owned))) return;
+                    break;
+                case ControlMessage::Gather:
+                    if (!sendRecords(this->control, this->owned)) return;
+                    break;
+                case ControlMessage::Quit:
+                    return;
+            }
+        }
+    }
+}
+
+DistributedFlock::DistributedFlock(unsigned int workers, unsigned int threadsPerWorker, float bound) : bound(bound) {
+    this->spawn(workers > 0 ? workers : 1, threadsPerWorker);
+}
+
+DistributedFlock::~DistributedFlock() {
+    ControlMessage message = {ControlMessage::Quit, 0, {}, 0.f};
+    for (Worker& worker : this->workers) {
+        if (worker.control >= 0) {
+            sendAll(worker.control, &message, sizeof(message));
+            close(worker.control);
+        }
+    }
+    for (Worker& worker : this->workers) {
+        if (worker.pid > 0) waitpid(worker.pid, nullptr, 0);
+    }
+}
+
+void DistributedFlock::spawn(unsigned int workers, unsigned int threadsPerWorker) {
+    // control[k]: coordinator end, worker end. link[k] joins worker k (end 0)
+    // to worker k + 1 (end 1), the last one closes the ring
+    std::vector<int> control(2 * workers, -1);
+    std::vector<int> link(workers > 1 ? 2 * workers : 0, -1);
+    for (unsigned int k = 0; k < workers; k++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, &control[2 * k]) != 0) {
+            this->fail("socketpair");
+            return;
+        }
+    }
+    for (unsigned int k = 0; k < link.size() / 2; k++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, &link[2 * k]) != 0) {
+            this->fail("socketpair");
+            return;
+        }
+    }
+
+    this->workers.resize(workers);
+    for (unsigned int k = 0; k < workers; k++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            this->fail("fork");
+            break;
+        }
+        if (pid == 0) {
+            int left = -1, right = -1;
+            if (workers > 1) {
+                right = link[2 * k];
+                left = link[2 * ((k + workers - 1) % workers) + 1];
+            }
+            // keep only this worker's sockets, so every end sees the others hang up
+            for (unsigned int j = 0; j < 2 * workers; j++) {
+                if (control[j] >= 0 && control[j] != control[2 * k + 1]) close(control[j]);
+            }
+            for (int fd : link) {
+                if (fd != left && fd != right) close(fd);
+            }
+            fcntl(left, F_SETFL, O_NONBLOCK);
+            fcntl(right, F_SETFL, O_NONBLOCK);
+
+            SlabWorker worker(k, workers, threadsPerWorker, this->bound, control[2 * k + 1], left, right);
+            worker.run();
+            _exit(0);
+        }
+        this->workers[k].pid = pid;
+        this->workers[k].control = control[2 * k];
+    }
+
+    for (unsigned int k = 0; k < workers; k++) {
+        close(control[2 * k + 1]);
+        if (this->workers[k].pid < 0) {
+            close(control[2 * k]);
+            this->workers[k].control = -1;
+        }
+    }
+    for (int fd : link) {
+        close(fd);
+    }
+}
+
+bool DistributedFlock::fail(const char* what) {
+    std::cerr << "Distributed flock error: " << what << std::endl;
+    this->failed = true;
+    return false;
+}
+
+bool DistributedFlock::reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities) {
+    if (this->failed) return false;
+    this->count = positions.size();
+    this->gatheredValid = false;
+
+    // hand every boid to the worker owning its slab
+    unsigned int workers = this->workers.size();
+    float width = 2.f * this->bound / workers;
+    std::vector<std::vector<BoidRecord>> slabs(workers);
+    for (unsigned int i = 0; i < this->count; i++) {
+        int slab = std::clamp(static_cast<int>(std::floor((positions[i].x + this->bound) / width)), 0, static_cast<int>(workers) - 1);
+        slabs[slab].push_back({i, positions[i].x, positions[i].y, positions[i].z, velocities[i].x, velocities[i].y, velocities[i].z});
+    }
+
+    for (unsigned int k = 0; k < workers; k++) {
+        ControlMessage message = {ControlMessage::Reset, static_cast<uint32_t>(slabs[k].size()), {}, 0.f};
+        if (!sendAll(this->workers[k].control, &message, sizeof(message)) ||
+            !sendAll(this->workers[k].control, slabs[k].data(), slabs[k].size() * sizeof(BoidRecord))) {
+            return this->fail("reset");
+        }
+    }
+    for (unsigned int k = 0; k < workers; k++) {
+        uint32_t owned = 0;
+        if (!receiveAll(this->workers[k].control, &owned, sizeof(owned))) return this->fail("reset");
+    }
+    return true;
+}
+
+bool DistributedFlock::update(const FlockParameters& params, float dt) {
+    if (this->failed) return false;
+    this->gatheredValid = false;
+
+    // halos and migration only reach the next slab. a step moves a boid by at
+    // most max(maxSpeed, 1) * dt, the speed limit of Flock::update
+    float width = 2.f * this->bound / this->workers.size();
+    const char* skipped = nullptr;
+    if (this->workers.size() > 1 && params.perceptionRadius >= width) {
+        skipped = "perception radius wider than a slab";
+    } else if (this->workers.size() > 1 && std::max(params.maxSpeed, 1.f) * dt >= width) {
+        skipped = "boids could cross more than one slab";
+    }
+    if (skipped) {
+        // only this step is rejected, the workers still hold a valid flock
+        if (skipped != this->skipReason) std::cerr << "Distributed flock: " << skipped << ", step skipped" << std::endl;
+        this->skipReason = skipped;
+        return false;
+    }
+    this->skipReason = nullptr;
+
+    ControlMessage message = {ControlMessage::Step, 0, params, dt};
+    for (Worker& worker : this->workers) {
+        if (!sendAll(worker.control, &message, sizeof(message))) return this->fail("step");
+    }
+    unsigned long total = 0;
+    for (Worker& worker : this->workers) {
+        uint32_t owned = 0;
+        if (!receiveAll(worker.control, &owned, sizeof(owned))) return this->fail("step");
+        total += owned;
+    }
+    if (total != this->count) return this->fail("boids lost in migration");
+    return true;
+}
+
+const BoidStore& DistributedFlock::gather() {
+    if (this->gatheredValid || this->failed) return this->gathered;
+
+    this->gathered.resize(this->count);
+    ControlMessage message = {ControlMessage::Gather, 0, {}, 0.f};
+    for (Worker& worker : this->workers) {
+        if (!sendAll(worker.control, &message, sizeof(message)) || !receiveRecords(worker.control, this->records)) {
+            this->fail("gather");
+            return this->gathered;
+        }
+        for (const BoidRecord& boid : this->records) {
+            if (boid.id >= this->count) continue;
+            this->gathered.setPosition(boid.id, glm::vec3(boid.x, boid.y, boid.z));
+            this->gathered.setVelocity(boid.id, glm::vec3(boid.vx, boid.vy, boid.vz));
+        }
+    }
+    this->gatheredValid = true;
+    return this->gathered;
+}
+
+unsigned int DistributedFlock::size() const {
+    return this->count;
+}
+
+unsigned int DistributedFlock::workerCount() const {
+    return this->workers.size();
+}
+
+bool DistributedFlock::isRunning() const {
+    return !this->failed;
+}
@@ -0,0 +1,72 @@
+#ifndef SIMULATION_DISTRIBUTED_FLOCK_HPP_
+#define SIMULATION_DISTRIBUTED_FLOCK_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/flock.hpp"
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <vector>
+
+// one boid on the wire between processes
+struct BoidRecord {
+    uint32_t id;
+    float x, y, z;
+    float vx, vy, vz;
+};
+
+// flock split along x into slabs, each owned and stepped by its own worker
+// process. workers form a ring over unix socket pairs: before a step every
+// worker sends its neighbors the boids within the perception radius of the
+// shared border (halo), after it the boids that left its slab (migration).
+// the ring closes over the wrap-around border, which only carries migrants
+// since neighbors are not searched across it. the coordinator (the process
+// that created the flock) only hands out boids, broadcasts steps and
+// gathers the state back by id.
+//
+// a step only depends on the previous one, so the result matches a single
+// Flock up to the order floating point sums are taken in.
+class DistributedFlock {
+    private:
+        struct Worker {
+            pid_t pid = -1;
+            int control = -1;
+        };
+
+        float bound;
+        unsigned int count = 0;
+        std::vector<Worker> workers;
+        std::vector<BoidRecord> records;
+        BoidStore gathered;
+        bool gatheredValid = false;
+        bool failed = false;
+        // why the last step was skipped, logged once per reason
+        const char* skipReason = nullptr;
+
+        void spawn(unsigned int workers, unsigned int threadsPerWorker);
+        bool fail(const char* what);
+
+    public:
+        // forks the workers right away, threadsPerWorker 0 means one per core
+        DistributedFlock(unsigned int workers, unsigned int threadsPerWorker = 1, float bound = 25.f);
+        ~DistributedFlock();
+        DistributedFlock(const DistributedFlock&) = delete;
+        DistributedFlock& operator=(const DistributedFlock&) = delete;
+
+        // false once a worker died or a message could not be sent, update also
+        // skips single steps that would reach past the next slab
+        bool reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+        bool update(const FlockParameters& params, float dt);
+
+        // every boid, indexed by id, fetched from the workers at most once per step
+        const BoidStore& gather();
+
+        unsigned int size() const;
+        unsigned int workerCount() const;
+        bool isRunning() const;
+};
+
+#endif  // SIMULATION_DISTRIBUTED_FLOCK_HPP_
@@ -0,0 +1,255 @@
+#include "simulation/flock.hpp"
+
+#include "utils/profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+// boids handed to a thread at a time
+const unsigned int GRAIN = 256;
+
+Flock::Flock(ThreadPool& pool, float bound)
+    : bound(bound), grid(bound), neighbors(bound), octree(pool, bound), pool(pool), accumulate(Steering::select()), accumulateCompact(Steering::selectCompact()), morton(pool) {
+}
+
+void Flock::reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities) {
+    this->front = 0;
+    this->boids[0].resize(positions.size());
+    this->boids[1].resize(positions.size());
+    this->ids.resize(positions.size());
+    this->identity = true;
+    this->stepsSinceReorder = 0;
+    this->orderedValid = false;
+    this->neighbors.invalidate();
+    this->lod.reset(positions.size());
+    this->steered = positions.size();
+
+    for (unsigned int i = 0; i < positions.size(); i++) {
+        this->boids[0].setPosition(i, positions[i]);
+        this->boids[0].setVelocity(i, velocities[i]);
+        this->ids[i] = i;
+    }
+}
+
+glm::vec3 Flock::steer(unsigned int i, const FlockParameters& params) const {
+    const BoidStore& boids = this->boids[this->front];
+    const BoidStore& sorted = this->grid.getSorted();
+    glm::vec3 position = boids.position(i);
+    float radius2 = params.perceptionRadius * params.perceptionRadius;
+
+    SteeringSums sums;
+    if (this->octreeEnabled) {
+        this->octree.accumulate(position, this->octree.getSlot(i), radius2, this->openingAngle, this->accumulate, sums);
+    } else if (this->neighbors.getSkin() > 0.f) {
+        // cached candidates, gathered one by one
+        this->neighbors.forEachCandidate(i, position, this->grid, [&](unsigned int j) {
+            float dx = boids.x[j] - position.x;
+            float dy = boids.y[j] - position.y;
+            float dz = boids.z[j] - position.z;
+            if (j != i && dx*dx + dy*dy + dz*dz < radius2) {
+                sums.total++;
+                sums.separation += glm::vec3(dx, dy, dz);
+                sums.cohesion += glm::vec3(boids.x[j], boids.y[j], boids.z[j]);
+                sums.alignment += glm::vec3(boids.vx[j], boids.vy[j], boids.vz[j]);
+            }
+        });
+    } else {
+        // neighbors are read from the cell-sorted copy, one row of cells at a time
+        unsigned int self = this->grid.getSlot(i);
+        if (this->grid.isCompact()) {
+            const CompactStore& compact = this->grid.getCompact();
+            this->grid.forEachRow(position, [&](unsigned int begin, unsigned int end) {
+                this->accumulateCompact(compact, begin, end, self, position, radius2, sums);
+            });
+        } else {
+            this->grid.forEachRow(position, [&](unsigned int begin, unsigned int end) {
+                this->accumulate(sorted, begin, end, self, position, radius2, sums);
+            });
+        }
+    }
+
+    glm::vec3 separation = sums.separation;
+    glm::vec3 cohesion = sums.cohesion;
+    glm::vec3 alignment = sums.alignment;
+    if (sums.total > 0) {
+        separation = -glm::normalize(separation);
+        cohesion /= sums.total;
+        cohesion = glm::normalize(cohesion - position);
+        alignment /= sums.total;
+        alignment = glm::normalize(alignment);
+    }
+
+    return separation * params.separation + cohesion * params.cohesion + alignment * params.alignment;
+}
+
+void Flock::update(const FlockParameters& params, float dt) {
+    PROFILE_SCOPE(Profiler::FlockUpdate);
+    const BoidStore& boids = this->boids[this->front];
+    BoidStore& next = this->boids[this->front ^ 1];
+
+    // bin boids once per step, the grid follows the perception radius.
+    // with neighbor lists the grid is only rebuilt along with them, the
+    // octree replaces it altogether.
+    {
+        PROFILE_SCOPE(Profiler::GridBuild);
+        // only the grid search reads the compact copy. a step never leaves
+        // a speed above max(maxSpeed, 1)
+        bool gridSearch = !this->octreeEnabled && this->neighbors.getSkin() <= 0.f;
+        this->grid.setCompact(this->compact && gridSearch, std::max(params.maxSpeed, 1.f));
+        if (this->octreeEnabled) {
+            this->octree.build(boids);
+        } else if (this->neighbors.getSkin() > 0.f) {
+            this->neighbors.update(boids, params.perceptionRadius, this->grid, this->pool);
+        } else {
+            this->grid.build(boids, params.perceptionRadius);
+        }
+    }
+
+    bool lodEnabled = this->lod.getSettings().enabled;
+    std::atomic<unsigned int> steered{0};
+    this->pool.parallelFor(0, this->size(), GRAIN, [&](unsigned int begin, unsigned int end) {
+        unsigned int count = 0;
+        for (unsigned int k = begin; k < end; k++) {
+            // octree queries run in tree order, so consecutive boids walk
+            // the same nodes
+            unsigned int i = this->octreeEnabled ? this->octree.getIndex(k) : k;
+
+            // boids that wait keep their state, the others cover every tick
+            // they skipped at once
+            unsigned int ticks = lodEnabled ? this->lod.due(this->ids[i], boids.position(i)) : 1;
+            if (ticks == 0) {
+                next.setPosition(i, boids.position(i));
+                next.setVelocity(i, boids.velocity(i));
+                continue;
+            }
+            count++;
+
+            glm::vec3 steering = this->steer(i, params) * static_cast<float>(ticks);
+            glm::vec3 velocity = boids.velocity(i) + steering / (params.separation + params.cohesion + params.alignment);
+
+            if (glm::length(velocity) > params.maxSpeed) {
+                velocity /= glm::length(velocity);
+            }
+
+            // check if boids go out of the cube, if so wrap them to the other side
+            glm::vec3 position = boids.position(i) + velocity * (dt * ticks);
+            if (position.x < -this->bound) position.x = this->bound;
+            if (position.y < -this->bound) position.y = this->bound;
+            if (position.z < -this->bound) position.z = this->bound;
+            if (position.x > +this->bound) position.x = -this->bound;
+            if (position.y > +this->bound) position.y = -this->bound;
+            if (position.z > +this->bound) position.z = -this->bound;
+
+            next.setPosition(i, position);
+            next.setVelocity(i, velocity);
+        }
+        steered += count;
+    });
+
+    this->front ^= 1;
+    this->steered = steered;
+    if (lodEnabled) this->lod.advance();
+    this->orderedValid = false;
+
+    if (this->reorderInterval > 0 && ++this->stepsSinceReorder >= this->reorderInterval) {
+        this->reorder();
+    }
+}
+
+void Flock::setReorderInterval(unsigned int interval) {
+    this->reorderInterval = interval;
+    this->stepsSinceReorder = 0;
+}
+
+void Flock::reorder() {
+    PROFILE_SCOPE(Profiler::Reorder);
+    const BoidStore& boids = this->boids[this->front];
+    BoidStore& next = this->boids[this->front ^ 1];
+    const std::vector<unsigned int>& order = this->morton.sort(boids, this->bound);
+
+    // the back buffer is free between steps, gather into it and swap
+    std::vector<unsigned int> ids(this->ids.size());
+    this->pool.parallelFor(0, this->size(), GRAIN, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int k = begin; k < end; k++) {
+            unsigned int i = order[k];
+            next.x[k] = boids.x[i];
+            next.y[k] = boids.y[i];
+            next.z[k] = boids.z[i];
+            next.vx[k] = boids.vx[i];
+            next.vy[k] = boids.vy[i];
+            next.vz[k] = boids.vz[i];
+            ids[k] = this->ids[i];
+        }
+    });
+
+    this->ids.swap(ids);
+    this->front ^= 1;
+    this->neighbors.invalidate();
+    this->identity = false;
+    this->stepsSinceReorder = 0;
+    this->orderedValid = false;
+}
+
+unsigned int Flock::size() const {
+    return this->boids[this->front].size();
+}
+
+const BoidStore& Flock::getBoids() const {
+    return this->boids[this->front];
+}
+
+void Flock::setNeighborSkin(float skin) {
+    this->neighbors.setSkin(skin);
+}
+
+void Flock::setOctree(bool enabled, float openingAngle) {
+    this->octreeEnabled = enabled;
+    this->openingAngle = openingAngle;
+    // the lists are not kept up to date meanwhile
+    this->neighbors.invalidate();
+}
+
+void Flock::setCompact(bool enabled) {
+    this->compact = enabled;
+}
+
+void Flock::setLod(const LodSettings& settings) {
+    // turning it back on starts from a clean schedule
+    if (settings.enabled && !this->lod.getSettings().enabled) {
+        this->lod.reset(this->size());
+    }
+    this->lod.configure(settings);
+}
+
+unsigned int Flock::getSteered() const {
+    return this->steered;
+}
+
+const NeighborListStats& Flock::getNeighborStats() const {
+    return this->neighbors.getStats();
+}
+
+const std::vector<unsigned int>& Flock::getIds() const {
+    return this->ids;
+}
+
+const BoidStore& Flock::getOrdered() {
+    const BoidStore& boids = this->boids[this->front];
+    if (this->identity) return boids;
+
+    // scattered at most once per step
+    if (!this->orderedValid) {
+        this->ordered.resize(boids.size());
+        for (unsigned int k = 0; k < boids.size(); k++) {
+            unsigned int id = this->ids[k];
+            this->ordered.x[id] = boids.x[k];
+            this->ordered.y[id] = boids.y[k];
+            this->ordered.z[id] = boids.z[k];
+            this->ordered.vx[id] = boids.vx[k];
+            this->ordered.vy[id] = boids.vy[k];
+            this->ordered.vz[id] = boids.vz[k];
+        }
+        this->orderedValid = true;
+    }
+    return this->ordered;
+}
@@ -0,0 +1,97 @@
+#ifndef SIMULATION_FLOCK_HPP_
+#define SIMULATION_FLOCK_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/lod.hpp"
+#include "simulation/morton.hpp"
+#include "simulation/neighbor_list.hpp"
+#include "simulation/octree.hpp"
+#include "simulation/spatial_grid.hpp"
+#include "simulation/steering.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <vector>
+
+struct FlockParameters {
+    float perceptionRadius;
+    float separation;
+    float cohesion;
+    float alignment;
+    float maxSpeed;
+};
+
+// boid state kept in two buffers: a step reads frame N from the front
+// buffer and writes frame N+1 into the back one, then swaps them. every
+// boid only depends on the previous frame, so the result is the same for
+// any number of threads.
+//
+// boids can also be moved around in memory every few steps (z-order, for
+// cache locality), so every slot carries a stable id. getOrdered() gives
+// the state indexed by id, which is what snapshots and recordings use.
+class Flock {
+    private:
+        BoidStore boids[2];
+        unsigned int front = 0;
+        float bound;
+        SpatialGrid grid;
+        NeighborList neighbors;
+        Octree octree;
+        bool octreeEnabled = false;
+        float openingAngle = 0.f;
+        ThreadPool& pool;
+        AccumulateFunction accumulate;
+        CompactAccumulateFunction accumulateCompact;
+        bool compact = false;
+        LodScheduler lod;
+        unsigned int steered = 0;
+
+        // ids[slot] is the id of the boid stored at slot
+        std::vector<unsigned int> ids;
+        bool identity = true;
+        MortonSort morton;
+        unsigned int reorderInterval = 0;
+        unsigned int stepsSinceReorder = 0;
+        BoidStore ordered;
+        bool orderedValid = false;
+
+        glm::vec3 steer(unsigned int i, const FlockParameters& params) const;
+
+    public:
+        Flock(ThreadPool& pool, float bound = 25.f);
+        void reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+        void update(const FlockParameters& params, float dt);
+        unsigned int size() const;
+        const BoidStore& getBoids() const;
+        const std::vector<unsigned int>& getIds() const;
+
+        // boids indexed by id rather than by slot
+        const BoidStore& getOrdered();
+
+        // sorts the boids along a z-order curve every interval steps, 0 never
+        void setReorderInterval(unsigned int interval);
+        void reorder();
+
+        // reuses neighbor lists built at perception radius + skin across
+        // steps, 0 searches the grid every step
+        void setNeighborSkin(float skin);
+        const NeighborListStats& getNeighborStats() const;
+
+        // searches an octree instead of the grid or the lists, see Octree
+        // for the opening angle
+        void setOctree(bool enabled, float openingAngle);
+
+        // grid searches read neighbors from a 16-bit copy of the state
+        // (see CompactStore for the error bound). the state itself stays in
+        // floats, so the error does not build up across steps.
+        void setCompact(bool enabled);
+
+        // steps boids the camera does not look at closely less often, see
+        // LodScheduler. neighbors still see them where they last stepped.
+        void setLod(const LodSettings& settings);
+        // boids actually stepped by the last update
+        unsigned int getSteered() const;
+};
+
+#endif  // SIMULATION_FLOCK_HPP_
@@ -0,0 +1,160 @@
+#include "simulation/flock_simulation.hpp"
+
+#include "simulation/philox.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const FlockParameters FlockSimulation::DEFAULT_PARAMETERS = {8 * 0.3536f, 0.12f, 0.12f, 0.12f, 2.f};
+
+// boids start this far inside the walls
+const float MARGIN = 0.6f;
+// clustered flocks, spread of each cluster as a fraction of the bound
+const unsigned int CLUSTERS = 8;
+const float CLUSTER_SPREAD = 0.08f;
+// boids per chunk of a parallel fill
+const unsigned int FILL_GRAIN = 16384;
+
+// the third counter word keeps boids and clusters apart
+enum Stream { BoidStream, ClusterStream };
+
+// two normally distributed values (Box-Muller)
+static glm::vec2 gaussian(float u0, float u1) {
+    float radius = std::sqrt(-2.f * std::log(1.f - u0));
+    float angle = 2.f * static_cast<float>(M_PI) * u1;
+    return radius * glm::vec2(std::cos(angle), std::sin(angle));
+}
+
+FlockSimulation::FlockSimulation(unsigned int threads, float bound) : pool(threads), flock(pool, bound), bound(bound) {
+}
+
+void FlockSimulation::randomFlock(
+        unsigned int count, uint64_t seed, float bound, float maxSpeed,
+        std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities,
+        Distribution distribution, ThreadPool* pool
+    ) {
+    float inner = std::max(bound - MARGIN, 0.f);
+
+    // cluster centers stay a few spreads away from the walls
+    float spread = CLUSTER_SPREAD * bound;
+    glm::vec3 centers[CLUSTERS];
+    for (unsigned int c = 0; c < CLUSTERS; c++) {
+        Philox::Block bits = Philox::generate({c, 0, ClusterStream, 0}, seed);
+        glm::vec3 u(Philox::uniform(bits[0]), Philox::uniform(bits[1]), Philox::uniform(bits[2]));
+        centers[c] = (2.f * u - 1.f) * std::max(inner - 2.f * spread, 0.f);
+    }
+
+    positions.resize(count);
+    velocities.resize(count);
+    auto fill = [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            // eight words per boid, the last one of each block is spare
+            Philox::Block a = Philox::generate({i, 0, BoidStream, 0}, seed);
+            Philox::Block b = Philox::generate({i, 1, BoidStream, 0}, seed);
+            glm::vec3 u(Philox::uniform(a[0]), Philox::uniform(a[1]), Philox::uniform(a[2]));
+            glm::vec3 v(Philox::uniform(b[0]), Philox::uniform(b[1]), Philox::uniform(b[2]));
+
+            glm::vec3 position;
+            if (distribution == Sphere) {
+                // uniform direction, radius weighted by volume
+                float z = 2.f * u.x - 1.f;
+                float angle = 2.f * static_cast<float>(M_PI) * u.y;
+                float ring = std::sqrt(std::max(1.f - z * z, 0.f));
+                position = inner * std::cbrt(u.z) * glm::vec3(ring * std::cos(angle), ring * std::sin(angle), z);
+            } else if (distribution == Clustered) {
+                glm::vec2 xy = gaussian(u.x, u.y);
+                glm::vec2 z = gaussian(u.z, Philox::uniform(b[3]));
+                glm::vec3 offset = spread * glm::vec3(xy, z.x);
+                position = glm::clamp(centers[a[3] % CLUSTERS] + offset, -inner, inner);
+            } else {
+                position = (2.f * u - 1.f) * inner;
+            }
+
+            positions[i] = position;
+            velocities[i] = (2.f * v - 1.f) * maxSpeed;
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, count, FILL_GRAIN, fill);
+    } else {
+        fill(0, count);
+    }
+}
+
+const char* FlockSimulation::distributionName(Distribution distribution) {
+    switch (distribution) {
+        case Cube: return "cube";
+        case Sphere: return "sphere";
+        case Clustered: return "clustered";
+        default: return "unknown";
+    }
+}
+
+bool FlockSimulation::parseDistribution(const std::string& name, Distribution& distribution) {
+    for (int d = 0; d < DistributionCount; d++) {
+        if (name == distributionName(static_cast<Distribution>(d))) {
+            distribution = static_cast<Distribution>(d);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FlockSimulation::reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities) {
+    this->flock.reset(positions, velocities);
+    this->tick = 0;
+}
+
+void FlockSimulation::randomize(unsigned int count, uint64_t seed, Distribution distribution) {
+    std::vector<glm::vec3> positions, velocities;
+    randomFlock(count, seed, this->bound, this->params.maxSpeed, positions, velocities, distribution, &this->pool);
+    this->reset(positions, velocities);
+}
+
+void FlockSimulation::step(unsigned int steps) {
+    for (unsigned int s = 0; s < steps; s++) {
+        this->flock.update(this->params, this->dt);
+        this->tick++;
+    }
+}
+
+const FlockParameters& FlockSimulation::getParameters() const {
+    return this->params;
+}
+
+void FlockSimulation::setParameters(const FlockParameters& params) {
+    this->params = params;
+}
+
+float FlockSimulation::getDt() const {
+    return this->dt;
+}
+
+void FlockSimulation::setDt(float dt) {
+    this->dt = dt;
+}
+
+float FlockSimulation::getBound() const {
+    return this->bound;
+}
+
+unsigned long FlockSimulation::getTick() const {
+    return this->tick;
+}
+
+unsigned int FlockSimulation::size() const {
+    return this->flock.size();
+}
+
+const BoidStore& FlockSimulation::state() {
+    return this->flock.getOrdered();
+}
+
+Flock& FlockSimulation::getFlock() {
+    return this->flock;
+}
+
+ThreadPool& FlockSimulation::getPool() {
+    return this->pool;
+}
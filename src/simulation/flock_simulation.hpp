@@ -0,0 +1,74 @@
+#ifndef SIMULATION_FLOCK_SIMULATION_HPP_
+#define SIMULATION_FLOCK_SIMULATION_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/flock.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// one self-contained flock: its own thread pool, state, parameters and
+// time step, so any number of them can run side by side in one process.
+// this is what libboids exposes through its C API (capi/boids.h), the
+// viewer's simulation thread steps one too.
+class FlockSimulation {
+    public:
+        // the viewer's defaults
+        static const FlockParameters DEFAULT_PARAMETERS;
+
+        // where random flocks start: spread over the cube, inside the
+        // largest ball that fits in it, or gathered in a few dense clusters
+        enum Distribution { Cube, Sphere, Clustered, DistributionCount };
+
+    private:
+        ThreadPool pool;
+        Flock flock;
+        float bound;
+        FlockParameters params = DEFAULT_PARAMETERS;
+        float dt = 1.f / 120.f;
+        unsigned long tick = 0;
+
+    public:
+        // threads 0 means one per core
+        FlockSimulation(unsigned int threads = 0, float bound = 25.f);
+        FlockSimulation(const FlockSimulation&) = delete;
+        FlockSimulation& operator=(const FlockSimulation&) = delete;
+
+        // velocity components are uniform in [-maxSpeed, maxSpeed]. boid i
+        // only depends on (seed, i), so the flock is the same for a seed
+        // everywhere and for any number of threads filling it
+        static void randomFlock(
+            unsigned int count, uint64_t seed, float bound, float maxSpeed,
+            std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities,
+            Distribution distribution = Cube, ThreadPool* pool = nullptr
+        );
+        static const char* distributionName(Distribution distribution);
+        // false for unknown names
+        static bool parseDistribution(const std::string& name, Distribution& distribution);
+
+        void reset(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+        // fills the flock on the simulation's threads
+        void randomize(unsigned int count, uint64_t seed, Distribution distribution = Cube);
+        void step(unsigned int steps = 1);
+
+        const FlockParameters& getParameters() const;
+        void setParameters(const FlockParameters& params);
+        float getDt() const;
+        void setDt(float dt);
+        float getBound() const;
+        unsigned long getTick() const;
+        unsigned int size() const;
+
+        // boids indexed by id, valid until the next step or reset
+        const BoidStore& state();
+
+        // search settings (reorder, skin, octree, compact, lod)
+        Flock& getFlock();
+        ThreadPool& getPool();
+};
+
+#endif  // SIMULATION_FLOCK_SIMULATION_HPP_
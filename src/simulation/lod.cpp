@@ -0,0 +1,52 @@
+#include "simulation/lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// boids this far past the frustum edges (in clip space) still count as
+// visible, so none freezes right at the border of the screen
+const float FRUSTUM_MARGIN = 1.1f;
+
+void LodScheduler::configure(const LodSettings& settings) {
+    this->settings = settings;
+    this->settings.farInterval = std::clamp(settings.farInterval, 1u, 64u);
+    this->settings.hiddenInterval = std::clamp(settings.hiddenInterval, 1u, 64u);
+}
+
+const LodSettings& LodScheduler::getSettings() const {
+    return this->settings;
+}
+
+void LodScheduler::reset(unsigned int count) {
+    this->lag.assign(count, 0);
+    this->tick = 0;
+}
+
+unsigned int LodScheduler::interval(const glm::vec3& position) const {
+    glm::vec4 clip = this->settings.viewProjection * glm::vec4(position, 1.f);
+    float limit = clip.w * FRUSTUM_MARGIN;
+    bool visible = clip.w > 0.f && std::fabs(clip.x) <= limit && std::fabs(clip.y) <= limit;
+    if (!visible) return this->settings.hiddenInterval;
+
+    glm::vec3 offset = position - this->settings.eye;
+    float far = this->settings.farDistance;
+    return glm::dot(offset, offset) > far * far ? this->settings.farInterval : 1;
+}
+
+unsigned int LodScheduler::due(unsigned int id, const glm::vec3& position) {
+    unsigned int interval = this->interval(position);
+    unsigned int elapsed = this->lag[id] + 1u;
+
+    // boids that just moved to a faster bucket are overdue and step right
+    // away instead of waiting for their turn
+    if ((id + this->tick) % interval == 0 || elapsed >= interval) {
+        this->lag[id] = 0;
+        return elapsed;
+    }
+    this->lag[id] = static_cast<uint16_t>(elapsed);
+    return 0;
+}
+
+void LodScheduler::advance() {
+    this->tick++;
+}
@@ -0,0 +1,49 @@
+#ifndef SIMULATION_LOD_HPP_
+#define SIMULATION_LOD_HPP_
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// camera the level of detail is chosen for
+struct LodSettings {
+    bool enabled = false;
+    glm::vec3 eye = glm::vec3(0.f);
+    glm::mat4 viewProjection = glm::mat4(1.f);
+    // visible boids farther than this from the eye count as far
+    float farDistance = 100.f;
+    // ticks between steps of far and of off-screen boids
+    unsigned int farInterval = 2;
+    unsigned int hiddenInterval = 4;
+};
+
+// staggers the steps of boids the camera does not look at closely. visible
+// near boids step every tick, far ones every farInterval ticks and the ones
+// outside the view frustum every hiddenInterval ticks, each covering the
+// ticks it skipped. boids of a bucket are spread round-robin over the ticks
+// by id, so every tick steps about the same share of them.
+class LodScheduler {
+    private:
+        LodSettings settings;
+        // ticks since the last step of every boid, by id
+        std::vector<uint16_t> lag;
+        unsigned long tick = 0;
+
+    public:
+        void configure(const LodSettings& settings);
+        const LodSettings& getSettings() const;
+        void reset(unsigned int count);
+
+        // ticks between steps of a boid at position
+        unsigned int interval(const glm::vec3& position) const;
+
+        // ticks boid id has to cover this tick, 0 when it waits. safe to
+        // call concurrently for different ids.
+        unsigned int due(unsigned int id, const glm::vec3& position);
+
+        // call once after every tick
+        void advance();
+};
+
+#endif  // SIMULATION_LOD_HPP_
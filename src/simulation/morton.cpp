@@ -0,0 +1,105 @@
+#include "simulation/morton.hpp"
+
+#include <algorithm>
+
+// radix sort digits, 4 passes cover the 30 bit codes
+const unsigned int RADIX_BITS = 8;
+const unsigned int RADIX = 1 << RADIX_BITS;
+const unsigned int PASSES = (3 * Morton::BITS + RADIX_BITS - 1) / RADIX_BITS;
+
+// boids per block, each block is histogrammed and scattered by one thread
+const unsigned int BLOCK = 16384;
+
+// spreads the low 10 bits of v so there are two zero bits between each
+static uint32_t spread(uint32_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+static uint32_t quantize(float value, float bound) {
+    const float cells = static_cast<float>(1 << Morton::BITS);
+    float cell = (value + bound) / (2.f * bound) * cells;
+    return static_cast<uint32_t>(std::clamp(cell, 0.f, cells - 1.f));
+}
+
+uint32_t Morton::encode(float x, float y, float z, float bound) {
+    return spread(quantize(x, bound)) | (spread(quantize(y, bound)) << 1) | (spread(quantize(z, bound)) << 2);
+}
+
+MortonSort::MortonSort(ThreadPool& pool) : pool(pool) {
+}
+
+const std::vector<unsigned int>& MortonSort::sort(const BoidStore& boids, float bound) {
+    unsigned int count = boids.size();
+    unsigned int blocks = (count + BLOCK - 1) / BLOCK;
+    for (unsigned int i = 0; i < 2; i++) {
+        this->keys[i].resize(count);
+        this->order[i].resize(count);
+    }
+    this->histograms.resize(static_cast<size_t>(blocks) * RADIX);
+
+    this->pool.parallelFor(0, count, BLOCK, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            this->keys[0][i] = Morton::encode(boids.x[i], boids.y[i], boids.z[i], bound);
+            this->order[0][i] = i;
+        }
+    });
+
+    unsigned int source = 0;
+    for (unsigned int pass = 0; pass < PASSES; pass++) {
+        unsigned int shift = pass * RADIX_BITS;
+        const std::vector<uint32_t>& keysIn = this->keys[source];
+        const std::vector<unsigned int>& orderIn = this->order[source];
+        std::vector<uint32_t>& keysOut = this->keys[source ^ 1];
+        std::vector<unsigned int>& orderOut = this->order[source ^ 1];
+
+        // digit histogram of every block
+        this->pool.parallelFor(0, blocks, 1, [&](unsigned int first, unsigned int last) {
+            for (unsigned int block = first; block < last; block++) {
+                unsigned int* histogram = &this->histograms[static_cast<size_t>(block) * RADIX];
+                std::fill(histogram, histogram + RADIX, 0u);
+                unsigned int end = std::min(count, (block + 1) * BLOCK);
+                for (unsigned int i = block * BLOCK; i < end; i++) {
+                    histogram[(keysIn[i] >> shift) & (RADIX - 1)]++;
+                }
+            }
+        });
+
+        // digit-major prefix sum turns the counts into each block's first
+        // output slot, so equal digits keep their block order
+        unsigned int offset = 0;
+        for (unsigned int digit = 0; digit < RADIX; digit++) {
+            for (unsigned int block = 0; block < blocks; block++) {
+                unsigned int& slot = this->histograms[static_cast<size_t>(block) * RADIX + digit];
+                unsigned int n = slot;
+                slot = offset;
+                offset += n;
+            }
+        }
+
+        this->pool.parallelFor(0, blocks, 1, [&](unsigned int first, unsigned int last) {
+            for (unsigned int block = first; block < last; block++) {
+                unsigned int* cursor = &this->histograms[static_cast<size_t>(block) * RADIX];
+                unsigned int end = std::min(count, (block + 1) * BLOCK);
+                for (unsigned int i = block * BLOCK; i < end; i++) {
+                    unsigned int slot = cursor[(keysIn[i] >> shift) & (RADIX - 1)]++;
+                    keysOut[slot] = keysIn[i];
+                    orderOut[slot] = orderIn[i];
+                }
+            }
+        });
+
+        source ^= 1;
+    }
+
+    this->result = source;
+    return this->order[source];
+}
+
+const std::vector<uint32_t>& MortonSort::getKeys() const {
+    return this->keys[this->result];
+}
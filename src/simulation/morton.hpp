@@ -0,0 +1,39 @@
+#ifndef SIMULATION_MORTON_HPP_
+#define SIMULATION_MORTON_HPP_
+
+#include "simulation/boid_store.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Morton {
+    // bits per axis of a code, 30 bits in total
+    const unsigned int BITS = 10;
+
+    // z-order curve code of a position inside the [-bound, bound] cube
+    uint32_t encode(float x, float y, float z, float bound);
+}
+
+// orders boids along a z-order curve, so boids close in space end up close
+// in memory. keys are sorted with a parallel least significant digit radix
+// sort, which is stable: the order does not depend on the number of threads.
+class MortonSort {
+    private:
+        ThreadPool& pool;
+        std::vector<uint32_t> keys[2];
+        std::vector<unsigned int> order[2];
+        std::vector<unsigned int> histograms;
+        unsigned int result = 0;
+
+    public:
+        MortonSort(ThreadPool& pool);
+
+        // permutation that sorts the boids, order[k] is the index of the
+        // boid that goes to slot k
+        const std::vector<unsigned int>& sort(const BoidStore& boids, float bound);
+        // codes of the last sort, in sorted order
+        const std::vector<uint32_t>& getKeys() const;
+};
+
+#endif  // SIMULATION_MORTON_HPP_
@@ -0,0 +1,114 @@
+#include "simulation/neighbor_list.hpp"
+
+#include <chrono>
+#include <cmath>
+
+using Clock = std::chrono::steady_clock;
+
+// boids handed to a thread at a time while building
+const unsigned int GRAIN = 256;
+// every boid checks every escaped one, past this a rebuild is cheaper
+const unsigned int MAX_ESCAPED = 32;
+
+double NeighborListStats::savedSeconds() const {
+    if (this->rebuilds == 0) return 0.0;
+    double build = this->buildSeconds / this->rebuilds;
+    return (this->steps - this->rebuilds) * build - this->checkSeconds;
+}
+
+NeighborList::NeighborList(float bound) : bound(bound) {
+}
+
+void NeighborList::setSkin(float skin) {
+    if (skin != this->skin) {
+        this->skin = skin;
+        this->valid = false;
+    }
+}
+
+void NeighborList::invalidate() {
+    this->valid = false;
+}
+
+void NeighborList::build(const BoidStore& boids, SpatialGrid& grid, ThreadPool& pool) {
+    unsigned int n = boids.size();
+    float cutoff = this->radius + this->skin;
+    float cutoff2 = cutoff * cutoff;
+    grid.build(boids, cutoff);
+
+    // count, prefix sum, fill: two passes over the candidates keep the
+    // rows in a single array without per-thread buffers
+    this->offsets.assign(n + 1, 0);
+    pool.parallelFor(0, n, GRAIN, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            glm::vec3 position = boids.position(i);
+            unsigned int count = 0;
+            grid.forEachCandidate(position, [&](unsigned int j) {
+                glm::vec3 d = boids.position(j) - position;
+                if (j != i && glm::dot(d, d) < cutoff2) count++;
+            });
+            this->offsets[i + 1] = count;
+        }
+    });
+    for (unsigned int i = 0; i < n; i++) {
+        this->offsets[i + 1] += this->offsets[i];
+    }
+
+    this->neighbors.resize(this->offsets[n]);
+    pool.parallelFor(0, n, GRAIN, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            glm::vec3 position = boids.position(i);
+            unsigned int k = this->offsets[i];
+            grid.forEachCandidate(position, [&](unsigned int j) {
+                glm::vec3 d = boids.position(j) - position;
+                if (j != i && glm::dot(d, d) < cutoff2) this->neighbors[k++] = j;
+            });
+        }
+    });
+
+    this->reference.resize(n);
+    for (unsigned int i = 0; i < n; i++) {
+        this->reference[i] = boids.position(i);
+    }
+    this->escapedFlags.assign(n, 0);
+    this->escaped.clear();
+    this->valid = true;
+}
+
+bool NeighborList::check(const BoidStore& boids) {
+    float limit2 = 0.25f * this->skin * this->skin;
+
+    for (unsigned int i = 0; i < boids.size(); i++) {
+        if (this->escapedFlags[i]) continue;
+
+        glm::vec3 d = boids.position(i) - this->reference[i];
+        if (glm::dot(d, d) <= limit2) continue;
+
+        // a jump across the cube is a wrap, anything else is a real move
+        bool wrapped = std::fabs(d.x) > this->bound || std::fabs(d.y) > this->bound || std::fabs(d.z) > this->bound;
+        if (!wrapped || this->escaped.size() >= MAX_ESCAPED) return true;
+        this->escapedFlags[i] = 1;
+        this->escaped.push_back(i);
+    }
+    return false;
+}
+
+bool NeighborList::update(const BoidStore& boids, float radius, SpatialGrid& grid, ThreadPool& pool) {
+    Clock::time_point start = Clock::now();
+    this->stats.steps++;
+
+    bool rebuild = !this->valid || radius != this->radius || boids.size() != this->reference.size();
+    if (!rebuild) {
+        rebuild = this->check(boids);
+        if (!rebuild) {
+            this->stats.checkSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+            return false;
+        }
+    }
+
+    this->radius = radius;
+    this->build(boids, grid, pool);
+    this->stats.rebuilds++;
+    this->stats.buildSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef SIMULATION_NEIGHBOR_LIST_HPP_
+#define SIMULATION_NEIGHBOR_LIST_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/spatial_grid.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <vector>
+
+struct NeighborListStats {
+    unsigned long steps = 0;
+    unsigned long rebuilds = 0;
+    // grid and list builds, and the per-step displacement checks
+    double buildSeconds = 0.0;
+    double checkSeconds = 0.0;
+
+    // builds skipped, costed at the average build
+    double savedSeconds() const;
+};
+
+// per-boid lists of the boids within perception radius + skin, stored
+// back to back (compressed sparse rows) and reused across steps. as long as
+// no boid moved more than skin / 2 since the build, every pair closer than
+// the radius is still in the lists.
+//
+// boids that wrapped around the cube are the exception: they are kept in a
+// short escaped list that every boid checks, and they find their own
+// neighbors in the grid of the last build. too many of them also trigger
+// a rebuild.
+class NeighborList {
+    private:
+        float bound;
+        float skin = 0.f;
+        float radius = 0.f;
+        bool valid = false;
+
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> neighbors;
+        // positions at the last build
+        std::vector<glm::vec3> reference;
+        std::vector<unsigned char> escapedFlags;
+        std::vector<unsigned int> escaped;
+
+        NeighborListStats stats;
+
+        void build(const BoidStore& boids, SpatialGrid& grid, ThreadPool& pool);
+        bool check(const BoidStore& boids);
+
+    public:
+        NeighborList(float bound);
+
+        // 0 disables the lists
+        void setSkin(float skin);
+        float getSkin() const;
+        // forces a rebuild, e.g. after the boids were moved around in memory
+        void invalidate();
+
+        // rebuilds the grid and the lists when needed, returns true if it did
+        bool update(const BoidStore& boids, float radius, SpatialGrid& grid, ThreadPool& pool);
+
+        // calls f(j) for every boid j that may be within the radius of boid i,
+        // i itself included. callers still check the actual distance.
+        template <typename F>
+        void forEachCandidate(unsigned int i, const glm::vec3& position, const SpatialGrid& grid, F&& f) const;
+
+        const NeighborListStats& getStats() const;
+};
+
+inline float NeighborList::getSkin() const {
+    return this->skin;
+}
+
+inline const NeighborListStats& NeighborList::getStats() const {
+    return this->stats;
+}
+
+template <typename F>
+void NeighborList::forEachCandidate(unsigned int i, const glm::vec3& position, const SpatialGrid& grid, F&& f) const {
+    if (this->escapedFlags[i]) {
+        // the list of i is stale, search around its new position instead.
+        // the others are within skin / 2 of where the grid has them.
+        grid.forEachCandidate(position, [&](unsigned int j) {
+            if (!this->escapedFlags[j]) f(j);
+        });
+    } else {
+        for (unsigned int k = this->offsets[i]; k < this->offsets[i + 1]; k++) {
+            unsigned int j = this->neighbors[k];
+            if (!this->escapedFlags[j]) f(j);
+        }
+    }
+
+    for (unsigned int j : this->escaped) {
+        f(j);
+    }
+}
+
+#endif  // SIMULATION_NEIGHBOR_LIST_HPP_
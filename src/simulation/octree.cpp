@@ -0,0 +1,152 @@
+#include "simulation/octree.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// boids below which a node is not split any further
+const unsigned int LEAF_SIZE = 64;
+
+Octree::Octree(ThreadPool& pool, float bound) : bound(bound), morton(pool) {
+}
+
+void Octree::build(const BoidStore& boids) {
+    unsigned int n = boids.size();
+    const std::vector<unsigned int>& order = this->morton.sort(boids, this->bound);
+
+    this->sorted.resize(n);
+    this->boidSlot.resize(n);
+    this->boidIndex.assign(order.begin(), order.end());
+    for (unsigned int k = 0; k < n; k++) {
+        unsigned int i = order[k];
+        this->sorted.x[k] = boids.x[i];
+        this->sorted.y[k] = boids.y[i];
+        this->sorted.z[k] = boids.z[i];
+        this->sorted.vx[k] = boids.vx[i];
+        this->sorted.vy[k] = boids.vy[i];
+        this->sorted.vz[k] = boids.vz[i];
+        this->boidSlot[i] = k;
+    }
+
+    this->nodes.clear();
+    if (n == 0) return;
+    Node root = {};
+    root.begin = 0;
+    root.end = n;
+    this->nodes.push_back(root);
+    this->split(0, 0);
+}
+
+void Octree::split(unsigned int index, unsigned int level) {
+    unsigned int begin = this->nodes[index].begin;
+    unsigned int end = this->nodes[index].end;
+
+    if (end - begin <= LEAF_SIZE || level == Morton::BITS) {
+        Node& leaf = this->nodes[index];
+        leaf.min = leaf.max = this->sorted.position(begin);
+        leaf.position = leaf.velocity = glm::vec3(0.f);
+        for (unsigned int k = begin; k < end; k++) {
+            glm::vec3 position = this->sorted.position(k);
+            leaf.min = glm::min(leaf.min, position);
+            leaf.max = glm::max(leaf.max, position);
+            leaf.position += position;
+            leaf.velocity += this->sorted.velocity(k);
+        }
+        leaf.count = end - begin;
+        leaf.firstChild = 0;
+        leaf.children = 0;
+        return;
+    }
+
+    // boids are sorted by code, so every child is a run of equal octants
+    const std::vector<uint32_t>& keys = this->morton.getKeys();
+    unsigned int shift = 3 * (Morton::BITS - 1 - level);
+    unsigned int firstChild = this->nodes.size();
+    for (unsigned int k = begin; k < end;) {
+        uint32_t octant = (keys[k] >> shift) & 7;
+        unsigned int last = k + 1;
+        while (last < end && ((keys[last] >> shift) & 7) == octant) last++;
+
+        Node child = {};
+        child.begin = k;
+        child.end = last;
+        this->nodes.push_back(child);
+        k = last;
+    }
+    unsigned int children = this->nodes.size() - firstChild;
+
+    // nodes may move while the children are split, only indices are kept
+    Node aggregate = this->nodes[index];
+    aggregate.firstChild = firstChild;
+    aggregate.children = children;
+    aggregate.count = 0;
+    aggregate.position = aggregate.velocity = glm::vec3(0.f);
+    for (unsigned int c = 0; c < children; c++) {
+        this->split(firstChild + c, level + 1);
+        const Node& child = this->nodes[firstChild + c];
+        aggregate.min = c == 0 ? child.min : glm::min(aggregate.min, child.min);
+        aggregate.max = c == 0 ? child.max : glm::max(aggregate.max, child.max);
+        aggregate.position += child.position;
+        aggregate.velocity += child.velocity;
+        aggregate.count += child.count;
+    }
+    this->nodes[index] = aggregate;
+}
+
+void Octree::accumulate(
+        const glm::vec3& position, unsigned int self, float radius2, float openingAngle,
+        AccumulateFunction kernel, SteeringSums& sums
+    ) const {
+    if (this->nodes.empty()) return;
+
+    // adds a whole node, minus the boid itself if it lies below
+    auto take = [&](const Node& node) {
+        sums.total += node.count;
+        sums.separation += node.position - static_cast<float>(node.count) * position;
+        sums.cohesion += node.position;
+        sums.alignment += node.velocity;
+        if (self >= node.begin && self < node.end) {
+            sums.total--;
+            sums.cohesion -= this->sorted.position(self);
+            sums.alignment -= this->sorted.velocity(self);
+        }
+    };
+
+    float angle2 = openingAngle * openingAngle;
+    unsigned int stack[8 * Morton::BITS + 8];
+    unsigned int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = this->nodes[stack[--top]];
+
+        // closest point of the box out of range: nothing below is
+        glm::vec3 near = glm::clamp(position, node.min, node.max) - position;
+        if (glm::dot(near, near) >= radius2) continue;
+
+        // farthest corner in range: everything below is
+        glm::vec3 far = glm::max(glm::abs(node.min - position), glm::abs(node.max - position));
+        if (glm::dot(far, far) < radius2) {
+            take(node);
+            continue;
+        }
+
+        if (node.children == 0) {
+            kernel(this->sorted, node.begin, node.end, self, position, radius2, sums);
+            continue;
+        }
+
+        // small and far enough: all of the node or none of it
+        glm::vec3 extent = node.max - node.min;
+        float size = std::max(extent.x, std::max(extent.y, extent.z));
+        glm::vec3 centroid = node.position / static_cast<float>(node.count) - position;
+        float distance2 = glm::dot(centroid, centroid);
+        if (size * size < angle2 * distance2) {
+            if (distance2 < radius2) take(node);
+            continue;
+        }
+
+        for (unsigned int c = 0; c < node.children; c++) {
+            stack[top++] = node.firstChild + c;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef SIMULATION_OCTREE_HPP_
+#define SIMULATION_OCTREE_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/morton.hpp"
+#include "simulation/steering.hpp"
+#include "simulation/thread_pool.hpp"
+
+#include <vector>
+
+// octree over the flock for large perception radii. every node keeps the
+// number of boids below it with their summed position and velocity, which
+// is all the steering sums need: a node whose bounding box lies entirely
+// inside the perception sphere is added as one term, exactly. nodes that
+// straddle the sphere are opened, unless they look smaller than the
+// opening angle from the boid, in which case the whole node is taken (or
+// left out) depending on whether its centroid is in range. an opening
+// angle of 0 never approximates.
+//
+// the tree is built from the boids sorted by morton code, so the boids of
+// every node are contiguous and leaves run through the steering kernels.
+class Octree {
+    private:
+        struct Node {
+            // tight bounds of the boids below the node
+            glm::vec3 min;
+            glm::vec3 max;
+            glm::vec3 position;
+            glm::vec3 velocity;
+            unsigned int count;
+            // slots [begin, end) of the sorted boids
+            unsigned int begin;
+            unsigned int end;
+            // children are stored next to each other, none for a leaf
+            unsigned int firstChild;
+            unsigned int children;
+        };
+
+        float bound;
+        MortonSort morton;
+        std::vector<Node> nodes;
+        std::vector<unsigned int> boidSlot;
+        std::vector<unsigned int> boidIndex;
+        BoidStore sorted;
+
+        void split(unsigned int index, unsigned int level);
+
+    public:
+        Octree(ThreadPool& pool, float bound);
+
+        void build(const BoidStore& boids);
+
+        const BoidStore& getSorted() const;
+        unsigned int getSlot(unsigned int i) const;
+        unsigned int getIndex(unsigned int slot) const;
+
+        // adds the boids within sqrt(radius2) of position to sums, leaving
+        // out slot self
+        void accumulate(
+            const glm::vec3& position, unsigned int self, float radius2, float openingAngle,
+            AccumulateFunction kernel, SteeringSums& sums
+        ) const;
+};
+
+inline const BoidStore& Octree::getSorted() const {
+    return this->sorted;
+}
+
+inline unsigned int Octree::getSlot(unsigned int i) const {
+    return this->boidSlot[i];
+}
+
+inline unsigned int Octree::getIndex(unsigned int slot) const {
+    return this->boidIndex[slot];
+}
+
+#endif  // SIMULATION_OCTREE_HPP_
@@ -0,0 +1,44 @@
+#ifndef SIMULATION_PHILOX_HPP_
+#define SIMULATION_PHILOX_HPP_
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"), a counter-based generator: every output block is a pure function of
+// a 128-bit counter and a 64-bit key, so item i can draw its numbers from
+// counter i on any thread, in any order, without shared state.
+namespace Philox {
+    typedef std::array<uint32_t, 4> Block;
+
+    const uint32_t MULTIPLIER_0 = 0xD2511F53;
+    const uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    const uint32_t WEYL_0 = 0x9E3779B9;
+    const uint32_t WEYL_1 = 0xBB67AE85;
+    const int ROUNDS = 10;
+
+    inline Block generate(Block counter, uint64_t key) {
+        uint32_t key0 = static_cast<uint32_t>(key);
+        uint32_t key1 = static_cast<uint32_t>(key >> 32);
+        for (int round = 0; round < ROUNDS; round++) {
+            uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * counter[0];
+            uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * counter[2];
+            counter = {
+                static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0,
+                static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1,
+                static_cast<uint32_t>(product0)
+            };
+            key0 += WEYL_0;
+            key1 += WEYL_1;
+        }
+        return counter;
+    }
+
+    // [0, 1) from the top 24 bits, every value exact in a float
+    inline float uniform(uint32_t bits) {
+        return (bits >> 8) * (1.f / 16777216.f);
+    }
+}
+
+#endif  // SIMULATION_PHILOX_HPP_
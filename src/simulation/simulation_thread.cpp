@@ -0,0 +1,340 @@
+#include "simulation/simulation_thread.hpp"
+
+#include <cmath>
+
+using Clock = std::chrono::steady_clock;
+
+// ticks the loop may fall behind before it gives up catching up
+const unsigned int MAX_LAG_TICKS = 5;
+
+SimulationThread::SimulationThread(const FlockParameters& params, float tickRate, float timeScale, float bound, unsigned int workers)
+    : bound(bound), simulation(0, bound), tickRate(tickRate), timeScale(timeScale) {
+    this->simulation.setParameters(params);
+    this->simulation.setDt(timeScale / tickRate);
+    if (workers > 0) {
+        this->distributed = std::make_unique<DistributedFlock>(workers, 1, bound);
+    }
+}
+
+SimulationThread::~SimulationThread() {
+    this->stop();
+}
+
+void SimulationThread::start() {
+    if (this->thread.joinable()) return;
+    this->stopping = false;
+    this->thread = std::thread(&SimulationThread::loop, this);
+}
+
+void SimulationThread::stop() {
+    this->stopping = true;
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+}
+
+void SimulationThread::push(Command command) {
+    std::lock_guard<std::mutex> lock(this->commandMutex);
+    this->commands.push_back(std::move(command));
+}
+
+void SimulationThread::pause() {
+    Command command;
+    command.type = Command::Pause;
+    this->push(std::move(command));
+}
+
+void SimulationThread::resume() {
+    Command command;
+    command.type = Command::Resume;
+    this->push(std::move(command));
+}
+
+void SimulationThread::reset(std::vector<glm::vec3> positions, std::vector<glm::vec3> velocities) {
+    Command command;
+    command.type = Command::Reset;
+    command.positions = std::move(positions);
+    command.velocities = std::move(velocities);
+    this->push(std::move(command));
+}
+
+void SimulationThread::setParameters(const FlockParameters& params) {
+    Command command;
+    command.type = Command::SetParameters;
+    command.params = params;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setTickRate(float tickRate) {
+    Command command;
+    command.type = Command::SetTickRate;
+    command.tickRate = tickRate;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setReorderInterval(unsigned int interval) {
+    Command command;
+    command.type = Command::SetReorderInterval;
+    command.interval = interval;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setNeighborSkin(float skin) {
+    Command command;
+    command.type = Command::SetNeighborSkin;
+    command.skin = skin;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setOctree(bool enabled, float openingAngle) {
+    Command command;
+    command.type = Command::SetOctree;
+    command.octree = enabled;
+    command.openingAngle = openingAngle;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setCompact(bool enabled) {
+    Command command;
+    command.type = Command::SetCompact;
+    command.compact = enabled;
+    this->push(std::move(command));
+}
+
+void SimulationThread::setLod(const LodSettings& settings) {
+    Command command;
+    command.type = Command::SetLod;
+    command.lod = settings;
+    this->push(std::move(command));
+}
+
+void SimulationThread::startRecording(const std::string& path, uint64_t seed) {
+    Command command;
+    command.type = Command::StartRecording;
+    command.path = path;
+    command.seed = seed;
+    this->recording = true;
+    this->push(std::move(command));
+}
+
+void SimulationThread::stopRecording() {
+    Command command;
+    command.type = Command::StopRecording;
+    this->recording = false;
+    this->push(std::move(command));
+}
+
+ThreadPool& SimulationThread::pool() {
+    return this->simulation.getPool();
+}
+
+bool SimulationThread::isRecording() const {
+    return this->recording;
+}
+
+uint64_t SimulationThread::recordedFrames() const {
+    return this->recorder.getWritten();
+}
+
+uint64_t SimulationThread::droppedFrames() const {
+    return this->recorder.getDropped();
+}
+
+void SimulationThread::resetFlock(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities) {
+    if (this->distributed) {
+        this->distributed->reset(positions, velocities);
+    } else {
+        this->simulation.reset(positions, velocities);
+    }
+}
+
+bool SimulationThread::step() {
+    if (this->distributed) {
+        // a failed worker stops the flock where it was, the error is logged once
+        return this->distributed->isRunning() && this->distributed->update(this->simulation.getParameters(), this->simulation.getDt());
+    }
+    this->simulation.step();
+    return true;
+}
+
+unsigned int SimulationThread::flockSize() const {
+    return this->distributed ? this->distributed->size() : this->simulation.size();
+}
+
+const BoidStore& SimulationThread::state() {
+    return this->distributed ? this->distributed->gather() : this->simulation.state();
+}
+
+bool SimulationThread::applyCommands() {
+    std::deque<Command> pending;
+    {
+        std::lock_guard<std::mutex> lock(this->commandMutex);
+        pending.swap(this->commands);
+    }
+
+    // returns true when the flock changed without a step, so it is published
+    bool changed = false;
+    for (Command& command : pending) {
+        switch (command.type) {
+            case Command::Pause:
+                this->running = false;
+                break;
+            case Command::Resume:
+                this->running = true;
+                break;
+            case Command::Reset:
+                this->resetFlock(command.positions, command.velocities);
+                this->tick = 0;
+                this->generation++;
+                changed = true;
+                break;
+            case Command::SetParameters:
+                this->simulation.setParameters(command.params);
+                break;
+            case Command::SetTickRate:
+                if (command.tickRate > 0.f) {
+                    this->tickRate = command.tickRate;
+                    this->simulation.setDt(this->timeScale / this->tickRate);
+                }
+                break;
+            case Command::SetReorderInterval:
+                this->simulation.getFlock().setReorderInterval(command.interval);
+                break;
+            case Command::SetNeighborSkin:
+                this->simulation.getFlock().setNeighborSkin(command.skin);
+                break;
+            case Command::SetOctree:
+                this->simulation.getFlock().setOctree(command.octree, command.openingAngle);
+                break;
+            case Command::SetCompact:
+                this->simulation.getFlock().setCompact(command.compact);
+                break;
+            case Command::SetLod:
+                this->simulation.getFlock().setLod(command.lod);
+                break;
+            case Command::StartRecording:
+                if (this->recorder.open(command.path, this->flockSize(), command.seed, this->simulation.getParameters(), this->simulation.getDt(), this->bound)) {
+                    this->recorder.push(this->state().view(), this->tick, this->simulation.getParameters());
+                } else {
+                    this->recording = false;
+                }
+                break;
+            case Command::StopRecording:
+                this->recorder.close();
+                break;
+        }
+    }
+    return changed;
+}
+
+void SimulationThread::publish() {
+    FlockSnapshot& snapshot = this->snapshots.writeBuffer();
+    snapshot.boids = this->state();
+    snapshot.tick = this->tick;
+    snapshot.generation = this->generation;
+    snapshot.published = Clock::now();
+    snapshot.neighbors = this->simulation.getFlock().getNeighborStats();
+    snapshot.steered = this->distributed ? this->distributed->size() : this->simulation.getFlock().getSteered();
+    this->snapshots.publish();
+}
+
+void SimulationThread::advance(unsigned int ticks) {
+    if (this->thread.joinable()) return;
+    this->runTicks(ticks);
+}
+
+void SimulationThread::runTicks(unsigned int ticks) {
+    bool changed = this->applyCommands();
+    for (unsigned int i = 0; i < ticks && this->running; i++) {
+        // skipped steps keep the tick, so recordings get no duplicate frames
+        if (!this->step()) continue;
+        this->tick++;
+        changed = true;
+        if (this->recorder.isOpen()) {
+            this->recorder.push(this->state().view(), this->tick, this->simulation.getParameters());
+        }
+    }
+    if (changed) {
+        this->publish();
+    }
+}
+
+void SimulationThread::loop() {
+    Clock::time_point next = Clock::now();
+
+    while (!this->stopping) {
+        this->runTicks(1);
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / this->tickRate));
+
+        // fixed rate: wait for the next tick, but drop ticks instead of
+        // spiraling when a step takes longer than the period
+        next += period;
+        Clock::time_point now = Clock::now();
+        if (now - next > period * MAX_LAG_TICKS) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void SimulationThread::receive() {
+    if (this->snapshots.update()) {
+        const FlockSnapshot& snapshot = this->snapshots.readBuffer();
+        std::swap(this->previous, this->current);
+        this->current = snapshot.boids;
+        this->previousPublished = this->currentPublished;
+        this->currentPublished = snapshot.published;
+        this->currentNeighbors = snapshot.neighbors;
+        this->currentSteered = snapshot.steered;
+
+        // a new run starts without anything to blend from
+        if (snapshot.generation != this->currentGeneration || this->previous.size() != this->current.size()) {
+            this->previous = this->current;
+            this->previousPublished = this->currentPublished;
+            this->currentGeneration = snapshot.generation;
+        }
+    }
+}
+
+const BoidStore& SimulationThread::latest() {
+    this->receive();
+    return this->current;
+}
+
+const BoidStore& SimulationThread::interpolated(Clock::time_point now) {
+    this->receive();
+
+    // render one tick behind: alpha goes 0 -> 1 while waiting for the next tick
+    double interval = std::chrono::duration<double>(this->currentPublished - this->previousPublished).count();
+    double elapsed = std::chrono::duration<double>(now - this->currentPublished).count();
+    float alpha = interval > 0.0 ? static_cast<float>(elapsed / interval) : 1.f;
+    if (alpha > 1.f) alpha = 1.f;
+    if (alpha < 0.f) alpha = 0.f;
+
+    const BoidStore& a = this->previous;
+    const BoidStore& b = this->current;
+    BoidStore& out = this->blended;
+    out.resize(b.size());
+    for (unsigned int i = 0; i < b.size(); i++) {
+        // boids that wrapped around the cube jump instead of crossing it
+        float dx = b.x[i] - a.x[i], dy = b.y[i] - a.y[i], dz = b.z[i] - a.z[i];
+        bool wrapped = std::fabs(dx) > this->bound || std::fabs(dy) > this->bound || std::fabs(dz) > this->bound;
+        float t = wrapped ? 1.f : alpha;
+        out.x[i] = a.x[i] + dx * t;
+        out.y[i] = a.y[i] + dy * t;
+        out.z[i] = a.z[i] + dz * t;
+        out.vx[i] = a.vx[i] + (b.vx[i] - a.vx[i]) * alpha;
+        out.vy[i] = a.vy[i] + (b.vy[i] - a.vy[i]) * alpha;
+        out.vz[i] = a.vz[i] + (b.vz[i] - a.vz[i]) * alpha;
+    }
+
+    return out;
+}
+
+const NeighborListStats& SimulationThread::neighborStats() const {
+    return this->currentNeighbors;
+}
+
+unsigned int SimulationThread::steeredBoids() const {
+    return this->currentSteered;
+}
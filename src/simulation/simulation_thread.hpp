@@ -0,0 +1,148 @@
+#ifndef SIMULATION_SIMULATION_THREAD_HPP_
+#define SIMULATION_SIMULATION_THREAD_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/distributed_flock.hpp"
+#include "simulation/flock.hpp"
+#include "simulation/flock_simulation.hpp"
+#include "simulation/trajectory.hpp"
+#include "simulation/triple_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// flock state after a tick, as published to the renderer
+struct FlockSnapshot {
+    BoidStore boids;
+    unsigned long tick = 0;
+    // bumped on every reset, snapshots of different runs are not blended
+    unsigned long generation = 0;
+    std::chrono::steady_clock::time_point published;
+    NeighborListStats neighbors;
+    // boids stepped by the last tick, fewer than all of them with lod
+    unsigned int steered = 0;
+};
+
+// steps a FlockSimulation on its own thread at a fixed tick rate. the render thread
+// talks to it only through a command queue (play/stop/reset/parameters)
+// and reads snapshots from a lock-free triple buffer, interpolating between
+// the last two so motion stays smooth at any frame rate. ticks can also be
+// recorded to a trajectory file. snapshots and recordings are indexed by
+// boid id, whatever order the flock keeps its boids in.
+//
+// with workers the flock is stepped by a DistributedFlock instead, the
+// reorder, skin, octree, compact and lod settings then only apply to the in-process flock.
+class SimulationThread {
+    private:
+        struct Command {
+            enum Type { Pause, Resume, Reset, SetParameters, SetTickRate, SetReorderInterval, SetNeighborSkin, SetOctree, SetCompact, SetLod, StartRecording, StopRecording } type;
+            FlockParameters params = {};
+            float tickRate = 0.f;
+            unsigned int interval = 0;
+            float skin = 0.f;
+            bool octree = false;
+            bool compact = false;
+            LodSettings lod;
+            float openingAngle = 0.f;
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> velocities;
+            std::string path;
+            uint64_t seed = 0;
+        };
+
+        // simulation thread state
+        float bound;
+        FlockSimulation simulation;
+        std::unique_ptr<DistributedFlock> distributed;
+        float tickRate;
+        float timeScale;
+        bool running = true;
+        unsigned long tick = 0;
+        unsigned long generation = 0;
+        TrajectoryWriter recorder;
+
+        // shared state
+        TripleBuffer<FlockSnapshot> snapshots;
+        std::mutex commandMutex;
+        std::deque<Command> commands;
+        std::atomic<bool> stopping{false};
+        std::atomic<bool> recording{false};
+        std::thread thread;
+
+        // render thread state
+        BoidStore previous;
+        BoidStore current;
+        BoidStore blended;
+        unsigned long currentGeneration = 0;
+        NeighborListStats currentNeighbors;
+        unsigned int currentSteered = 0;
+        std::chrono::steady_clock::time_point previousPublished;
+        std::chrono::steady_clock::time_point currentPublished;
+
+        void loop();
+        void runTicks(unsigned int ticks);
+        bool applyCommands();
+        void resetFlock(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+        // false when the distributed flock skipped the step or stopped
+        bool step();
+        unsigned int flockSize() const;
+        // boids indexed by id
+        const BoidStore& state();
+        void publish();
+        void receive();
+        void push(Command command);
+
+    public:
+        // dt of every tick is timeScale / tickRate seconds. workers > 0 steps
+        // the flock in that many worker processes, forked right away
+        SimulationThread(const FlockParameters& params, float tickRate, float timeScale, float bound = 25.f, unsigned int workers = 0);
+        ~SimulationThread();
+        void start();
+        void stop();
+        // runs ticks on the calling thread instead, only when not started.
+        // offscreen capture steps a fixed number per frame this way so the
+        // video does not depend on how fast frames are rendered
+        void advance(unsigned int ticks);
+
+        // commands, safe to call from any thread
+        void pause();
+        void resume();
+        void reset(std::vector<glm::vec3> positions, std::vector<glm::vec3> velocities);
+        void setParameters(const FlockParameters& params);
+        void setTickRate(float tickRate);
+        void setReorderInterval(unsigned int interval);
+        void setNeighborSkin(float skin);
+        void setOctree(bool enabled, float openingAngle);
+        void setCompact(bool enabled);
+        void setLod(const LodSettings& settings);
+        void startRecording(const std::string& path, uint64_t seed);
+        void stopRecording();
+
+        // the simulation's threads, parallelFor calls from other threads
+        // wait for the running one
+        ThreadPool& pool();
+
+        bool isRecording() const;
+        uint64_t recordedFrames() const;
+        uint64_t droppedFrames() const;
+
+        // render thread only: the flock interpolated between the last two
+        // published ticks, one tick behind the simulation
+        const BoidStore& interpolated(std::chrono::steady_clock::time_point now);
+        // render thread only: the last published tick as is
+        const BoidStore& latest();
+        // render thread only: neighbor list counters of the last snapshot
+        const NeighborListStats& neighborStats() const;
+        // render thread only: boids stepped by the tick of the last snapshot
+        unsigned int steeredBoids() const;
+};
+
+#endif  // SIMULATION_SIMULATION_THREAD_HPP_
@@ -0,0 +1,101 @@
+#include "simulation/spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// the grid is capped so tiny radii do not allocate millions of empty cells
+const int MAX_RESOLUTION = 160;
+
+SpatialGrid::SpatialGrid(float bound) : bound(bound) {
+}
+
+void SpatialGrid::setCompact(bool enabled, float velocityRange) {
+    this->compact = enabled;
+    this->compactSorted.setRanges(this->bound, velocityRange);
+}
+
+void SpatialGrid::resize(float radius) {
+    this->radius = radius;
+
+    // largest number of cells per axis whose size is still >= radius
+    int cells = static_cast<int>(std::floor(2.f * this->bound / radius));
+    if (cells < 1) cells = 1;
+    if (cells > MAX_RESOLUTION) cells = MAX_RESOLUTION;
+
+    this->resolution = cells;
+    this->cellSize = 2.f * this->bound / cells;
+    this->cellStart.assign(static_cast<size_t>(cells) * cells * cells + 1, 0);
+}
+
+int SpatialGrid::cellCoordinate(float value) const {
+    // boids sitting exactly on the wrap-around border (or slightly past it
+    // before being wrapped) are clamped into the outermost cells
+    float t = (value + this->bound) / this->cellSize;
+    if (!(t >= 0.f)) return 0;
+    int cell = static_cast<int>(t);
+    return cell < this->resolution ? cell : this->resolution - 1;
+}
+
+void SpatialGrid::build(const BoidStore& boids, float radius) {
+    // perception radius changed, recompute the cell layout
+    if (radius != this->radius) {
+        this->resize(radius);
+    } else {
+        std::fill(this->cellStart.begin(), this->cellStart.end(), 0);
+    }
+
+    unsigned int n = boids.size();
+    this->boidCell.resize(n);
+    this->boidSlot.resize(n);
+    this->cellIndices.resize(n);
+
+    // counting sort: histogram of boids per cell
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int cell = (
+            this->cellCoordinate(boids.z[i]) * this->resolution +
+            this->cellCoordinate(boids.y[i])
+        ) * this->resolution + this->cellCoordinate(boids.x[i]);
+        this->boidCell[i] = cell;
+        this->cellStart[cell]++;
+    }
+
+    // inclusive prefix sum leaves the end of every cell in cellStart
+    for (size_t c = 1; c < this->cellStart.size(); c++) {
+        this->cellStart[c] += this->cellStart[c - 1];
+    }
+
+    // scatter backwards, turning each end into a start and keeping every
+    // cell sorted by boid index
+    for (unsigned int i = n; i-- > 0;) {
+        unsigned int slot = --this->cellStart[this->boidCell[i]];
+        this->cellIndices[slot] = i;
+        this->boidSlot[i] = slot;
+    }
+
+    // gather the state in cell order for the steering kernels
+    if (this->compact) {
+        this->compactSorted.resize(n);
+        for (unsigned int slot = 0; slot < n; slot++) {
+            this->compactSorted.encode(slot, boids, this->cellIndices[slot]);
+        }
+        return;
+    }
+    this->sorted.resize(n);
+    for (unsigned int slot = 0; slot < n; slot++) {
+        unsigned int i = this->cellIndices[slot];
+        this->sorted.x[slot] = boids.x[i];
+        this->sorted.y[slot] = boids.y[i];
+        this->sorted.z[slot] = boids.z[i];
+        this->sorted.vx[slot] = boids.vx[i];
+        this->sorted.vy[slot] = boids.vy[i];
+        this->sorted.vz[slot] = boids.vz[i];
+    }
+}
+
+float SpatialGrid::getCellSize() const {
+    return this->cellSize;
+}
+
+int SpatialGrid::getResolution() const {
+    return this->resolution;
+}
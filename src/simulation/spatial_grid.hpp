@@ -0,0 +1,105 @@
+#ifndef SIMULATION_SPATIAL_GRID_HPP_
+#define SIMULATION_SPATIAL_GRID_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/compact_store.hpp"
+
+#include <vector>
+
+// uniform grid over the simulation cube used to find boids inside the
+// perception radius without testing every pair. cells are at least as large
+// as the radius, so every neighbor of a boid lies in the 3x3x3 block of cells
+// around it. build() also keeps a copy of the flock sorted by cell, so the
+// boids of a row of cells sit next to each other in memory. in compact mode
+// that copy is quantized (see CompactStore) to halve the bytes the steering
+// kernels stream.
+class SpatialGrid {
+    private:
+        float bound;
+        float radius = 0.f;
+        float cellSize = 0.f;
+        int resolution = 0;
+        std::vector<unsigned int> cellStart;
+        std::vector<unsigned int> cellIndices;
+        std::vector<unsigned int> boidCell;
+        std::vector<unsigned int> boidSlot;
+        BoidStore sorted;
+        bool compact = false;
+        CompactStore compactSorted;
+
+        void resize(float radius);
+
+    public:
+        SpatialGrid(float bound);
+        // fill getCompact() instead of getSorted() from the next build on,
+        // velocity components are encoded within +-velocityRange
+        void setCompact(bool enabled, float velocityRange);
+        bool isCompact() const;
+        void build(const BoidStore& boids, float radius);
+        int cellCoordinate(float value) const;
+        float getCellSize() const;
+        int getResolution() const;
+
+        // boids in cell order and the slot boid i was moved to
+        const BoidStore& getSorted() const;
+        const CompactStore& getCompact() const;
+        unsigned int getSlot(unsigned int i) const;
+
+        // calls f(begin, end) for every row of cells around position, with
+        // [begin, end) a range of slots in getSorted()
+        template <typename F>
+        void forEachRow(const glm::vec3& position, F&& f) const;
+
+        // calls f(j) for every boid j in the cells around position, callers
+        // still have to check the actual distance
+        template <typename F>
+        void forEachCandidate(const glm::vec3& position, F&& f) const;
+};
+
+inline const BoidStore& SpatialGrid::getSorted() const {
+    return this->sorted;
+}
+
+inline const CompactStore& SpatialGrid::getCompact() const {
+    return this->compactSorted;
+}
+
+inline bool SpatialGrid::isCompact() const {
+    return this->compact;
+}
+
+inline unsigned int SpatialGrid::getSlot(unsigned int i) const {
+    return this->boidSlot[i];
+}
+
+template <typename F>
+void SpatialGrid::forEachRow(const glm::vec3& position, F&& f) const {
+    int cx = this->cellCoordinate(position.x);
+    int cy = this->cellCoordinate(position.y);
+    int cz = this->cellCoordinate(position.z);
+
+    int x0 = cx > 0 ? cx - 1 : 0, x1 = cx < this->resolution - 1 ? cx + 1 : cx;
+    int y0 = cy > 0 ? cy - 1 : 0, y1 = cy < this->resolution - 1 ? cy + 1 : cy;
+    int z0 = cz > 0 ? cz - 1 : 0, z1 = cz < this->resolution - 1 ? cz + 1 : cz;
+
+    for (int z = z0; z <= z1; z++) {
+        for (int y = y0; y <= y1; y++) {
+            // cells along x are contiguous, so a row is a single range
+            unsigned int row = (z * this->resolution + y) * this->resolution;
+            f(this->cellStart[row + x0], this->cellStart[row + x1 + 1]);
+        }
+    }
+}
+
+template <typename F>
+void SpatialGrid::forEachCandidate(const glm::vec3& position, F&& f) const {
+    this->forEachRow(position, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int k = begin; k < end; k++) {
+            f(this->cellIndices[k]);
+        }
+    });
+}
+
+#endif  // SIMULATION_SPATIAL_GRID_HPP_
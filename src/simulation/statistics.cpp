@@ -0,0 +1,73 @@
+#include "simulation/statistics.hpp"
+
+#include "simulation/spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FlockStatistics Statistics::measure(const BoidStore& boids, float radius, float bound) {
+    FlockStatistics result;
+    unsigned int n = boids.size();
+    if (n == 0) return result;
+
+    double speedSum = 0.0, speedSquares = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+        double speed = glm::length(boids.velocity(i));
+        speedSum += speed;
+        speedSquares += speed * speed;
+    }
+    result.meanSpeed = speedSum / n;
+    result.speedDeviation = std::sqrt(std::max(0.0, speedSquares / n - result.meanSpeed * result.meanSpeed));
+    result.polarization = Statistics::polarization(boids);
+
+    SpatialGrid grid(bound);
+    grid.build(boids, radius);
+    const BoidStore& sorted = grid.getSorted();
+    float radius2 = radius * radius;
+    unsigned long neighbors = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        glm::vec3 position = boids.position(i);
+        unsigned int self = grid.getSlot(i);
+        grid.forEachRow(position, [&](unsigned int begin, unsigned int end) {
+            for (unsigned int k = begin; k < end; k++) {
+                glm::vec3 d = sorted.position(k) - position;
+                if (k != self && glm::dot(d, d) < radius2) neighbors++;
+            }
+        });
+    }
+    result.meanNeighbors = static_cast<double>(neighbors) / n;
+
+    return result;
+}
+
+double Statistics::polarization(const BoidStore& boids) {
+    unsigned int n = boids.size();
+    if (n == 0) return 0.0;
+
+    glm::dvec3 heading(0.0);
+    for (unsigned int i = 0; i < n; i++) {
+        glm::vec3 velocity = boids.velocity(i);
+        double speed = glm::length(velocity);
+        if (speed > 0.0) heading += glm::dvec3(velocity) / speed;
+    }
+    return glm::length(heading) / n;
+}
+
+static bool close(double a, double b, double scale, double tolerance) {
+    return std::fabs(a - b) <= tolerance * scale;
+}
+
+bool Statistics::similar(const FlockStatistics& a, const FlockStatistics& b, double tolerance) {
+    return close(a.meanSpeed, b.meanSpeed, std::max(std::fabs(a.meanSpeed), 1e-6), tolerance)
+        && close(a.speedDeviation, b.speedDeviation, std::max(a.meanSpeed, 1e-6), tolerance)
+        && close(a.polarization, b.polarization, 1.0, tolerance)
+        && close(a.meanNeighbors, b.meanNeighbors, std::max(a.meanNeighbors, 1.0), tolerance);
+}
+
+void Statistics::print(std::ostream& out, const char* label, const FlockStatistics& statistics) {
+    out << label
+        << ": mean speed " << statistics.meanSpeed
+        << ", speed deviation " << statistics.speedDeviation
+        << ", polarization " << statistics.polarization
+        << ", neighbors " << statistics.meanNeighbors << std::endl;
+}
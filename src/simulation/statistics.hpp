@@ -0,0 +1,33 @@
+#ifndef SIMULATION_STATISTICS_HPP_
+#define SIMULATION_STATISTICS_HPP_
+
+#include "simulation/boid_store.hpp"
+
+#include <ostream>
+
+// aggregate measures of a flock. two runs of the same model from the same
+// start diverge boid by boid (floating point order, chaos), but these
+// should stay close, so they are used to compare backends.
+struct FlockStatistics {
+    double meanSpeed = 0.0;
+    double speedDeviation = 0.0;
+    // length of the mean heading, 1 when every boid flies the same way
+    double polarization = 0.0;
+    // boids inside the perception radius, on average
+    double meanNeighbors = 0.0;
+};
+
+namespace Statistics {
+    FlockStatistics measure(const BoidStore& boids, float radius, float bound);
+
+    // only the polarization, without the neighbor search of measure()
+    double polarization(const BoidStore& boids);
+
+    // true when every measure of b is within tolerance of a, relative to
+    // the value (or to 1 for polarization, which is already normalized)
+    bool similar(const FlockStatistics& a, const FlockStatistics& b, double tolerance);
+
+    void print(std::ostream& out, const char* label, const FlockStatistics& statistics);
+}
+
+#endif  // SIMULATION_STATISTICS_HPP_
@@ -0,0 +1,299 @@
+#include "simulation/steering.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STEERING_X86 1
+#include <immintrin.h>
+#endif
+
+void Steering::accumulateScalar(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    for (unsigned int k = begin; k < end; k++) {
+        float dx = boids.x[k] - position.x;
+        float dy = boids.y[k] - position.y;
+        float dz = boids.z[k] - position.z;
+        if (k != self && dx*dx + dy*dy + dz*dz < radius2) {
+            sums.total++;
+            sums.separation += glm::vec3(dx, dy, dz);
+            sums.cohesion += glm::vec3(boids.x[k], boids.y[k], boids.z[k]);
+            sums.alignment += glm::vec3(boids.vx[k], boids.vy[k], boids.vz[k]);
+        }
+    }
+}
+
+void Steering::accumulateCompactScalar(
+        const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    // distances are taken in position steps, the sums are only scaled
+    // back to world units once at the end
+    float step = boids.getPositionStep();
+    glm::vec3 p = position / step;
+    float r2 = radius2 / (step * step);
+    SteeringSums units;
+    for (unsigned int k = begin; k < end; k++) {
+        glm::vec3 neighbor = glm::vec3(boids.x[k], boids.y[k], boids.z[k]);
+        glm::vec3 d = neighbor - p;
+        if (k != self && d.x*d.x + d.y*d.y + d.z*d.z < r2) {
+            units.total++;
+            units.separation += d;
+            units.cohesion += neighbor;
+            units.alignment += glm::vec3(boids.vx[k], boids.vy[k], boids.vz[k]);
+        }
+    }
+    sums.separation += units.separation * step;
+    sums.cohesion += units.cohesion * step;
+    sums.alignment += units.alignment * boids.getVelocityStep();
+    sums.total += units.total;
+}
+
+#ifdef STEERING_X86
+
+// sse2 is part of x86-64, so this needs no runtime check
+void Steering::accumulateSse(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    const __m128 px = _mm_set1_ps(position.x);
+    const __m128 py = _mm_set1_ps(position.y);
+    const __m128 pz = _mm_set1_ps(position.z);
+    const __m128 r2 = _mm_set1_ps(radius2);
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i last = _mm_set1_epi32(static_cast<int>(end));
+    const __m128i skip = _mm_set1_epi32(static_cast<int>(self));
+
+    __m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+    __m128 cx = _mm_setzero_ps(), cy = _mm_setzero_ps(), cz = _mm_setzero_ps();
+    __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps(), az = _mm_setzero_ps();
+    __m128i total = _mm_setzero_si128();
+
+    // the store padding makes reading past end safe, those lanes are masked
+    for (unsigned int k = begin; k < end; k += 4) {
+        __m128 x = _mm_loadu_ps(boids.x + k);
+        __m128 y = _mm_loadu_ps(boids.y + k);
+        __m128 z = _mm_loadu_ps(boids.z + k);
+        __m128 dx = _mm_sub_ps(x, px);
+        __m128 dy = _mm_sub_ps(y, py);
+        __m128 dz = _mm_sub_ps(z, pz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+        __m128i index = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(k)), lane);
+        __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi32(index, skip), _mm_cmplt_epi32(index, last));
+        __m128 mask = _mm_and_ps(_mm_cmplt_ps(d2, r2), _mm_castsi128_ps(valid));
+
+        sx = _mm_add_ps(sx, _mm_and_ps(mask, dx));
+        sy = _mm_add_ps(sy, _mm_and_ps(mask, dy));
+        sz = _mm_add_ps(sz, _mm_and_ps(mask, dz));
+        cx = _mm_add_ps(cx, _mm_and_ps(mask, x));
+        cy = _mm_add_ps(cy, _mm_and_ps(mask, y));
+        cz = _mm_add_ps(cz, _mm_and_ps(mask, z));
+        ax = _mm_add_ps(ax, _mm_and_ps(mask, _mm_loadu_ps(boids.vx + k)));
+        ay = _mm_add_ps(ay, _mm_and_ps(mask, _mm_loadu_ps(boids.vy + k)));
+        az = _mm_add_ps(az, _mm_and_ps(mask, _mm_loadu_ps(boids.vz + k)));
+        total = _mm_sub_epi32(total, _mm_castps_si128(mask));
+    }
+
+    alignas(16) float lanes[9][4];
+    alignas(16) int counts[4];
+    _mm_store_ps(lanes[0], sx); _mm_store_ps(lanes[1], sy); _mm_store_ps(lanes[2], sz);
+    _mm_store_ps(lanes[3], cx); _mm_store_ps(lanes[4], cy); _mm_store_ps(lanes[5], cz);
+    _mm_store_ps(lanes[6], ax); _mm_store_ps(lanes[7], ay); _mm_store_ps(lanes[8], az);
+    _mm_store_si128(reinterpret_cast<__m128i*>(counts), total);
+
+    float sum[9];
+    for (int c = 0; c < 9; c++) {
+        sum[c] = (lanes[c][0] + lanes[c][1]) + (lanes[c][2] + lanes[c][3]);
+    }
+    sums.separation += glm::vec3(sum[0], sum[1], sum[2]);
+    sums.cohesion += glm::vec3(sum[3], sum[4], sum[5]);
+    sums.alignment += glm::vec3(sum[6], sum[7], sum[8]);
+    sums.total += counts[0] + counts[1] + counts[2] + counts[3];
+}
+
+__attribute__((target("avx2")))
+void Steering::accumulateAvx2(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    const __m256 px = _mm256_set1_ps(position.x);
+    const __m256 py = _mm256_set1_ps(position.y);
+    const __m256 pz = _mm256_set1_ps(position.z);
+    const __m256 r2 = _mm256_set1_ps(radius2);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i last = _mm256_set1_epi32(static_cast<int>(end));
+    const __m256i skip = _mm256_set1_epi32(static_cast<int>(self));
+
+    __m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+    __m256 cx = _mm256_setzero_ps(), cy = _mm256_setzero_ps(), cz = _mm256_setzero_ps();
+    __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps(), az = _mm256_setzero_ps();
+    __m256i total = _mm256_setzero_si256();
+
+    // eight neighbors per iteration, lanes past end or on self are masked
+    for (unsigned int k = begin; k < end; k += 8) {
+        __m256 x = _mm256_loadu_ps(boids.x + k);
+        __m256 y = _mm256_loadu_ps(boids.y + k);
+        __m256 z = _mm256_loadu_ps(boids.z + k);
+        __m256 dx = _mm256_sub_ps(x, px);
+        __m256 dy = _mm256_sub_ps(y, py);
+        __m256 dz = _mm256_sub_ps(z, pz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+        __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k)), lane);
+        __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(index, skip), _mm256_cmpgt_epi32(last, index));
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ), _mm256_castsi256_ps(valid));
+
+        sx = _mm256_add_ps(sx, _mm256_and_ps(mask, dx));
+        sy = _mm256_add_ps(sy, _mm256_and_ps(mask, dy));
+        sz = _mm256_add_ps(sz, _mm256_and_ps(mask, dz));
+        cx = _mm256_add_ps(cx, _mm256_and_ps(mask, x));
+        cy = _mm256_add_ps(cy, _mm256_and_ps(mask, y));
+        cz = _mm256_add_ps(cz, _mm256_and_ps(mask, z));
+        ax = _mm256_add_ps(ax, _mm256_and_ps(mask, _mm256_loadu_ps(boids.vx + k)));
+        ay = _mm256_add_ps(ay, _mm256_and_ps(mask, _mm256_loadu_ps(boids.vy + k)));
+        az = _mm256_add_ps(az, _mm256_and_ps(mask, _mm256_loadu_ps(boids.vz + k)));
+        total = _mm256_sub_epi32(total, _mm256_castps_si256(mask));
+    }
+
+    alignas(32) float lanes[9][8];
+    alignas(32) int counts[8];
+    _mm256_store_ps(lanes[0], sx); _mm256_store_ps(lanes[1], sy); _mm256_store_ps(lanes[2], sz);
+    _mm256_store_ps(lanes[3], cx); _mm256_store_ps(lanes[4], cy); _mm256_store_ps(lanes[5], cz);
+    _mm256_store_ps(lanes[6], ax); _mm256_store_ps(lanes[7], ay); _mm256_store_ps(lanes[8], az);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(counts), total);
+
+    float sum[9];
+    for (int c = 0; c < 9; c++) {
+        sum[c] = ((lanes[c][0] + lanes[c][1]) + (lanes[c][2] + lanes[c][3])) +
+                 ((lanes[c][4] + lanes[c][5]) + (lanes[c][6] + lanes[c][7]));
+    }
+    sums.separation += glm::vec3(sum[0], sum[1], sum[2]);
+    sums.cohesion += glm::vec3(sum[3], sum[4], sum[5]);
+    sums.alignment += glm::vec3(sum[6], sum[7], sum[8]);
+    for (int c = 0; c < 8; c++) {
+        sums.total += counts[c];
+    }
+}
+
+// eight int16 values widened to floats
+__attribute__((target("avx2")))
+static inline __m256 widen(const int16_t* values) {
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(packed));
+}
+
+__attribute__((target("avx2")))
+void Steering::accumulateCompactAvx2(
+        const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    // works in position steps like accumulateCompactScalar
+    float step = boids.getPositionStep();
+    const __m256 px = _mm256_set1_ps(position.x / step);
+    const __m256 py = _mm256_set1_ps(position.y / step);
+    const __m256 pz = _mm256_set1_ps(position.z / step);
+    const __m256 r2 = _mm256_set1_ps(radius2 / (step * step));
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i last = _mm256_set1_epi32(static_cast<int>(end));
+    const __m256i skip = _mm256_set1_epi32(static_cast<int>(self));
+
+    __m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+    __m256 cx = _mm256_setzero_ps(), cy = _mm256_setzero_ps(), cz = _mm256_setzero_ps();
+    __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps(), az = _mm256_setzero_ps();
+    __m256i total = _mm256_setzero_si256();
+
+    // same as accumulateAvx2, but every load is 16 bytes instead of 32
+    for (unsigned int k = begin; k < end; k += 8) {
+        __m256 x = widen(boids.x + k);
+        __m256 y = widen(boids.y + k);
+        __m256 z = widen(boids.z + k);
+        __m256 dx = _mm256_sub_ps(x, px);
+        __m256 dy = _mm256_sub_ps(y, py);
+        __m256 dz = _mm256_sub_ps(z, pz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+        __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k)), lane);
+        __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(index, skip), _mm256_cmpgt_epi32(last, index));
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ), _mm256_castsi256_ps(valid));
+
+        sx = _mm256_add_ps(sx, _mm256_and_ps(mask, dx));
+        sy = _mm256_add_ps(sy, _mm256_and_ps(mask, dy));
+        sz = _mm256_add_ps(sz, _mm256_and_ps(mask, dz));
+        cx = _mm256_add_ps(cx, _mm256_and_ps(mask, x));
+        cy = _mm256_add_ps(cy, _mm256_and_ps(mask, y));
+        cz = _mm256_add_ps(cz, _mm256_and_ps(mask, z));
+        ax = _mm256_add_ps(ax, _mm256_and_ps(mask, widen(boids.vx + k)));
+        ay = _mm256_add_ps(ay, _mm256_and_ps(mask, widen(boids.vy + k)));
+        az = _mm256_add_ps(az, _mm256_and_ps(mask, widen(boids.vz + k)));
+        total = _mm256_sub_epi32(total, _mm256_castps_si256(mask));
+    }
+
+    alignas(32) float lanes[9][8];
+    alignas(32) int counts[8];
+    _mm256_store_ps(lanes[0], sx); _mm256_store_ps(lanes[1], sy); _mm256_store_ps(lanes[2], sz);
+    _mm256_store_ps(lanes[3], cx); _mm256_store_ps(lanes[4], cy); _mm256_store_ps(lanes[5], cz);
+    _mm256_store_ps(lanes[6], ax); _mm256_store_ps(lanes[7], ay); _mm256_store_ps(lanes[8], az);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(counts), total);
+
+    float sum[9];
+    for (int c = 0; c < 9; c++) {
+        sum[c] = ((lanes[c][0] + lanes[c][1]) + (lanes[c][2] + lanes[c][3])) +
+                 ((lanes[c][4] + lanes[c][5]) + (lanes[c][6] + lanes[c][7]));
+    }
+    sums.separation += glm::vec3(sum[0], sum[1], sum[2]) * step;
+    sums.cohesion += glm::vec3(sum[3], sum[4], sum[5]) * step;
+    sums.alignment += glm::vec3(sum[6], sum[7], sum[8]) * boids.getVelocityStep();
+    for (int c = 0; c < 8; c++) {
+        sums.total += counts[c];
+    }
+}
+
+#else
+
+// without x86 intrinsics every kernel is the scalar one
+void Steering::accumulateSse(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    Steering::accumulateScalar(boids, begin, end, self, position, radius2, sums);
+}
+
+void Steering::accumulateAvx2(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    Steering::accumulateScalar(boids, begin, end, self, position, radius2, sums);
+}
+
+void Steering::accumulateCompactAvx2(
+        const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    ) {
+    Steering::accumulateCompactScalar(boids, begin, end, self, position, radius2, sums);
+}
+
+#endif
+
+AccumulateFunction Steering::select() {
+#ifdef STEERING_X86
+    if (__builtin_cpu_supports("avx2")) return Steering::accumulateAvx2;
+    return Steering::accumulateSse;
+#else
+    return Steering::accumulateScalar;
+#endif
+}
+
+// widening int16 loads need avx2 (or sse4.1), older cpus decode one by one
+CompactAccumulateFunction Steering::selectCompact() {
+#ifdef STEERING_X86
+    if (__builtin_cpu_supports("avx2")) return Steering::accumulateCompactAvx2;
+#endif
+    return Steering::accumulateCompactScalar;
+}
+
+const char* Steering::selectedName() {
+    AccumulateFunction kernel = Steering::select();
+    if (kernel == Steering::accumulateAvx2) return "avx2";
+    if (kernel == Steering::accumulateSse) return "sse2";
+    return "scalar";
+}
@@ -0,0 +1,59 @@
+#ifndef SIMULATION_STEERING_HPP_
+#define SIMULATION_STEERING_HPP_
+
+#include "glm/glm.hpp"
+
+#include "simulation/boid_store.hpp"
+#include "simulation/compact_store.hpp"
+
+// running separation/cohesion/alignment sums of one boid
+struct SteeringSums {
+    glm::vec3 separation = glm::vec3(0);
+    glm::vec3 cohesion = glm::vec3(0);
+    glm::vec3 alignment = glm::vec3(0);
+    unsigned int total = 0;
+};
+
+// adds every boid in slots [begin, end) of boids that lies closer than
+// sqrt(radius2) to position, skipping slot self
+using AccumulateFunction = void (*)(
+    const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+    const glm::vec3& position, float radius2, SteeringSums& sums
+);
+
+// same for quantized boids, decoded on the fly
+using CompactAccumulateFunction = void (*)(
+    const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+    const glm::vec3& position, float radius2, SteeringSums& sums
+);
+
+namespace Steering {
+    void accumulateScalar(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    );
+    void accumulateSse(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    );
+    void accumulateAvx2(
+        const BoidStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    );
+
+    void accumulateCompactScalar(
+        const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    );
+    void accumulateCompactAvx2(
+        const CompactStore& boids, unsigned int begin, unsigned int end, unsigned int self,
+        const glm::vec3& position, float radius2, SteeringSums& sums
+    );
+
+    // widest kernel the running cpu supports, picked once at startup
+    AccumulateFunction select();
+    CompactAccumulateFunction selectCompact();
+    const char* selectedName();
+}
+
+#endif  // SIMULATION_STEERING_HPP_
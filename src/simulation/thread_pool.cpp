@@ -0,0 +1,121 @@
+#include "simulation/thread_pool.hpp"
+
+// set on pool threads so nested parallelFor calls run inline
+thread_local bool insidePool = false;
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    // queue 0 belongs to the thread calling parallelFor
+    for (unsigned int i = 0; i < threads; i++) {
+        this->queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 1; i < threads; i++) {
+        this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (std::thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::size() const {
+    return this->queues.size();
+}
+
+void ThreadPool::parallelFor(unsigned int begin, unsigned int end, unsigned int grain, const RangeFunction& body) {
+    if (begin >= end) return;
+    if (grain == 0) grain = 1;
+
+    // nothing to share, or already on a pool thread
+    if (this->workers.empty() || insidePool || end - begin <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(this->submitMutex);
+    unsigned int chunks = (end - begin + grain - 1) / grain;
+    this->pending = chunks;
+    this->body = &body;
+
+    // deal contiguous blocks of chunks to each queue, stealing evens out the rest
+    unsigned int queueCount = this->queues.size();
+    for (unsigned int c = 0; c < chunks; c++) {
+        unsigned int first = begin + c * grain;
+        unsigned int last = end - first > grain ? first + grain : end;
+        WorkQueue& queue = *this->queues[static_cast<unsigned long>(c) * queueCount / chunks];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.push_back({first, last});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->generation++;
+    }
+    this->wake.notify_all();
+
+    insidePool = true;
+    this->runRanges(0);
+    insidePool = false;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this] { return this->pending.load() == 0; });
+    this->body = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    insidePool = true;
+    unsigned long seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [&] { return this->stopping || this->generation != seen; });
+            if (this->stopping) return;
+            seen = this->generation;
+        }
+        this->runRanges(index);
+    }
+}
+
+void ThreadPool::runRanges(unsigned int index) {
+    Range range;
+    while (this->pop(index, range) || this->steal(index, range)) {
+        (*this->body)(range.begin, range.end);
+        if (--this->pending == 0) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::pop(unsigned int index, Range& range) {
+    WorkQueue& queue = *this->queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) return false;
+    range = queue.ranges.front();
+    queue.ranges.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned int index, Range& range) {
+    unsigned int count = this->queues.size();
+    for (unsigned int offset = 1; offset < count; offset++) {
+        WorkQueue& victim = *this->queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.back();
+            victim.ranges.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#ifndef SIMULATION_THREAD_POOL_HPP_
+#define SIMULATION_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads sharing index ranges through per-thread
+// queues. a thread that runs out of work steals from the back of the
+// others, so uneven chunks (dense regions of the flock) balance out.
+class ThreadPool {
+    public:
+        using RangeFunction = std::function<void(unsigned int, unsigned int)>;
+
+    private:
+        struct Range {
+            unsigned int begin;
+            unsigned int end;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        const RangeFunction* body = nullptr;
+        std::atomic<unsigned int> pending{0};
+        std::mutex mutex;
+        std::mutex submitMutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        unsigned long generation = 0;
+        bool stopping = false;
+
+        void workerLoop(unsigned int index);
+        void runRanges(unsigned int index);
+        bool pop(unsigned int index, Range& range);
+        bool steal(unsigned int index, Range& range);
+
+    public:
+        // 0 threads means one per hardware thread
+        ThreadPool(unsigned int threads = 0);
+        ~ThreadPool();
+        unsigned int size() const;
+
+        // calls body(begin, end) over [begin, end) split in chunks of grain
+        // items and returns once all of them ran. the calling thread takes
+        // part in the work.
+        void parallelFor(unsigned int begin, unsigned int end, unsigned int grain, const RangeFunction& body);
+};
+
+#endif  // SIMULATION_THREAD_POOL_HPP_
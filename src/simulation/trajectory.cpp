@@ -0,0 +1,264 @@
+#include "simulation/trajectory.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char TRAJECTORY_MAGIC[8] = {'B', 'O', 'I', 'D', 'T', 'R', 'J', '1'};
+const uint32_t TRAJECTORY_VERSION = 1;
+
+uint64_t blockSize(uint32_t boids) {
+    return sizeof(TrajectoryFrame) + 6 * sizeof(float) * static_cast<uint64_t>(boids);
+}
+
+// writer
+TrajectoryWriter::TrajectoryWriter(unsigned int maxPending) : maxPending(maxPending) {
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    this->close();
+}
+
+bool TrajectoryWriter::open(const std::string& path, unsigned int boids, uint64_t seed, const FlockParameters& params, float dt, float bound) {
+    this->close();
+
+    this->file = std::fopen(path.c_str(), "wb");
+    if (!this->file) {
+        std::cerr << "Trajectory open error: " << path << std::endl;
+        return false;
+    }
+
+    std::memset(&this->header, 0, sizeof(TrajectoryHeader));
+    std::memcpy(this->header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC));
+    this->header.version = TRAJECTORY_VERSION;
+    this->header.boids = boids;
+    this->header.seed = seed;
+    this->header.params = params;
+    this->header.dt = dt;
+    this->header.bound = bound;
+
+    // header is rewritten with the frame count and index on close
+    std::fwrite(&this->header, sizeof(TrajectoryHeader), 1, this->file);
+    this->offset = sizeof(TrajectoryHeader);
+    this->index.clear();
+    this->written = 0;
+    this->dropped = 0;
+    this->failed = false;
+    this->closing = false;
+    this->thread = std::thread(&TrajectoryWriter::loop, this);
+    return true;
+}
+
+void TrajectoryWriter::push(const BoidView& boids, uint64_t tick, const FlockParameters& params) {
+    Block block;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->file || this->closing) return;
+        if (this->queued.size() >= this->maxPending) {
+            this->dropped++;
+            return;
+        }
+        if (!this->free.empty()) {
+            block = std::move(this->free.back());
+            this->free.pop_back();
+        }
+    }
+
+    // copy outside the lock, frames use the boid count of the header
+    unsigned int n = boids.size() < this->header.boids ? boids.size() : this->header.boids;
+    block.frame = {tick, this->header.boids, params};
+    block.data.assign(6 * static_cast<size_t>(this->header.boids), 0.f);
+    const float* arrays[6] = {boids.x, boids.y, boids.z, boids.vx, boids.vy, boids.vz};
+    for (int a = 0; a < 6; a++) {
+        std::memcpy(block.data.data() + a * static_cast<size_t>(this->header.boids), arrays[a], n * sizeof(float));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queued.push_back(std::move(block));
+    }
+    this->wake.notify_one();
+}
+
+void TrajectoryWriter::loop() {
+    while (true) {
+        Block block;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [this] { return this->closing || !this->queued.empty(); });
+            if (this->queued.empty()) return;
+            block = std::move(this->queued.front());
+            this->queued.pop_front();
+        }
+
+        bool ok = std::fwrite(&block.frame, sizeof(TrajectoryFrame), 1, this->file) == 1 &&
+                  std::fwrite(block.data.data(), sizeof(float), block.data.size(), this->file) == block.data.size();
+        if (ok) {
+            this->index.push_back(this->offset);
+            this->offset += blockSize(block.frame.boids);
+            this->written++;
+        } else {
+            this->failed = true;
+            this->dropped++;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->free.push_back(std::move(block));
+    }
+}
+
+bool TrajectoryWriter::close() {
+    if (!this->file) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closing = true;
+    }
+    this->wake.notify_one();
+    this->thread.join();
+
+    // index after the last frame, then the final header
+    this->header.frameCount = this->index.size();
+    this->header.indexOffset = this->offset;
+    bool ok = !this->failed;
+    ok = ok && std::fwrite(this->index.data(), sizeof(uint64_t), this->index.size(), this->file) == this->index.size();
+    ok = ok && std::fseek(this->file, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(&this->header, sizeof(TrajectoryHeader), 1, this->file) == 1;
+    ok = std::fclose(this->file) == 0 && ok;
+    this->file = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->free.clear();
+    }
+
+    if (!ok) std::cerr << "Trajectory write error" << std::endl;
+    return ok;
+}
+
+bool TrajectoryWriter::isOpen() const {
+    return this->file != nullptr;
+}
+
+uint64_t TrajectoryWriter::getWritten() const {
+    return this->written;
+}
+
+uint64_t TrajectoryWriter::getDropped() const {
+    return this->dropped;
+}
+
+// reader
+TrajectoryReader::~TrajectoryReader() {
+    this->close();
+}
+
+bool TrajectoryReader::open(const std::string& path) {
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Trajectory open error: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TrajectoryHeader)) {
+        std::cerr << "Trajectory too short: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Trajectory mmap error: " << path << std::endl;
+        return false;
+    }
+    this->data = static_cast<const unsigned char*>(mapping);
+    this->length = info.st_size;
+
+    std::memcpy(&this->header, this->data, sizeof(TrajectoryHeader));
+    if (std::memcmp(this->header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) != 0 ||
+        this->header.version != TRAJECTORY_VERSION) {
+        std::cerr << "Not a trajectory file: " << path << std::endl;
+        this->close();
+        return false;
+    }
+
+    // a frame fits when its header and both arrays end inside the file
+    auto fits = [this](uint64_t offset) {
+        if (offset < sizeof(TrajectoryHeader) || offset > this->length || this->length - offset < sizeof(TrajectoryFrame)) return false;
+        const TrajectoryFrame* frame = reinterpret_cast<const TrajectoryFrame*>(this->data + offset);
+        return blockSize(frame->boids) <= this->length - offset;
+    };
+
+    uint64_t indexOffset = this->header.indexOffset;
+    if (indexOffset > 0 && indexOffset <= this->length &&
+        this->header.frameCount <= (this->length - indexOffset) / sizeof(uint64_t)) {
+        // closed cleanly, use the stored index unless it points outside the file
+        this->offsets.resize(this->header.frameCount);
+        std::memcpy(this->offsets.data(), this->data + indexOffset, this->header.frameCount * sizeof(uint64_t));
+        if (!std::all_of(this->offsets.begin(), this->offsets.end(), fits)) {
+            std::cerr << "Trajectory index corrupt, scanning frames: " << path << std::endl;
+            this->offsets.clear();
+        }
+    }
+    if (this->offsets.empty()) {
+        // unfinished recording or bad index, walk the complete frame blocks
+        uint64_t offset = sizeof(TrajectoryHeader);
+        while (fits(offset)) {
+            this->offsets.push_back(offset);
+            offset += blockSize(reinterpret_cast<const TrajectoryFrame*>(this->data + offset)->boids);
+        }
+    }
+
+    madvise(const_cast<unsigned char*>(this->data), this->length, MADV_RANDOM);
+    return true;
+}
+
+void TrajectoryReader::close() {
+    if (this->data) {
+        munmap(const_cast<unsigned char*>(this->data), this->length);
+    }
+    this->data = nullptr;
+    this->length = 0;
+    this->offsets.clear();
+}
+
+bool TrajectoryReader::isOpen() const {
+    return this->data != nullptr;
+}
+
+const TrajectoryHeader& TrajectoryReader::getHeader() const {
+    return this->header;
+}
+
+uint64_t TrajectoryReader::frameCount() const {
+    return this->offsets.size();
+}
+
+const TrajectoryFrame& TrajectoryReader::frameInfo(uint64_t frame) const {
+    return *reinterpret_cast<const TrajectoryFrame*>(this->data + this->offsets[frame]);
+}
+
+BoidView TrajectoryReader::frame(uint64_t frame) const {
+    const TrajectoryFrame& info = this->frameInfo(frame);
+    const float* arrays = reinterpret_cast<const float*>(this->data + this->offsets[frame] + sizeof(TrajectoryFrame));
+    uint64_t n = info.boids;
+    return {info.boids, arrays, arrays + n, arrays + 2 * n, arrays + 3 * n, arrays + 4 * n, arrays + 5 * n};
+}
+
+void TrajectoryReader::prefetch(uint64_t frame) const {
+    if (frame >= this->offsets.size()) return;
+
+    // round down to a page, madvise wants aligned addresses
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    uint64_t begin = this->offsets[frame] / page * page;
+    uint64_t end = this->offsets[frame] + blockSize(this->frameInfo(frame).boids);
+    madvise(const_cast<unsigned char*>(this->data) + begin, end - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,116 @@
+#ifndef SIMULATION_TRAJECTORY_HPP_
+#define SIMULATION_TRAJECTORY_HPP_
+
+#include "simulation/boid_store.hpp"
+#include "simulation/flock.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// binary trajectory file, native byte order:
+//
+//   TrajectoryHeader                        72 bytes
+//   frame block 0..frameCount-1             TrajectoryFrame + 6 float arrays
+//                                           of `boids` entries (x y z vx vy vz)
+//   frame index                             frameCount uint64 block offsets
+//
+// frameCount and indexOffset are written when the recording is closed. a
+// file cut short (crash, full disk) still replays, its frames are found by
+// walking the blocks.
+struct TrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t boids;
+    uint64_t seed;
+    FlockParameters params;
+    float dt;
+    float bound;
+    uint32_t reserved;
+    uint64_t frameCount;
+    uint64_t indexOffset;
+};
+
+struct TrajectoryFrame {
+    uint64_t tick;
+    uint32_t boids;
+    FlockParameters params;
+};
+
+static_assert(sizeof(TrajectoryHeader) == 72, "trajectory header layout changed");
+static_assert(sizeof(TrajectoryFrame) == 32, "trajectory frame layout changed");
+
+// streams frames to disk from a background thread. push() only copies the
+// state into a recycled buffer, when the disk cannot keep up frames are
+// dropped (and counted) instead of stalling the simulation step.
+class TrajectoryWriter {
+    private:
+        struct Block {
+            TrajectoryFrame frame;
+            std::vector<float> data;
+        };
+
+        std::FILE* file = nullptr;
+        TrajectoryHeader header;
+        std::vector<uint64_t> index;
+        uint64_t offset = 0;
+        unsigned int maxPending;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Block> queued;
+        std::vector<Block> free;
+        bool closing = false;
+        std::thread thread;
+
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> failed{false};
+
+        void loop();
+
+    public:
+        TrajectoryWriter(unsigned int maxPending = 8);
+        ~TrajectoryWriter();
+        bool open(const std::string& path, unsigned int boids, uint64_t seed, const FlockParameters& params, float dt, float bound);
+        void push(const BoidView& boids, uint64_t tick, const FlockParameters& params);
+        // waits for queued frames, then writes the index and the final header
+        bool close();
+        bool isOpen() const;
+        uint64_t getWritten() const;
+        uint64_t getDropped() const;
+};
+
+// memory-maps a recording for random access replay. frames are read
+// straight from the mapping, so only the pages actually touched are
+// loaded, whatever the size of the file.
+class TrajectoryReader {
+    private:
+        const unsigned char* data = nullptr;
+        size_t length = 0;
+        TrajectoryHeader header;
+        std::vector<uint64_t> offsets;
+
+    public:
+        TrajectoryReader() = default;
+        TrajectoryReader(const TrajectoryReader&) = delete;
+        TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+        ~TrajectoryReader();
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const;
+        const TrajectoryHeader& getHeader() const;
+        uint64_t frameCount() const;
+        const TrajectoryFrame& frameInfo(uint64_t frame) const;
+        BoidView frame(uint64_t frame) const;
+        // hints the kernel to start reading a frame ahead of time
+        void prefetch(uint64_t frame) const;
+};
+
+#endif  // SIMULATION_TRAJECTORY_HPP_
@@ -0,0 +1,52 @@
+#ifndef SIMULATION_TRIPLE_BUFFER_HPP_
+#define SIMULATION_TRIPLE_BUFFER_HPP_
+
+#include <atomic>
+
+// lock-free single producer / single consumer triple buffer. the producer
+// always has a buffer to write, the consumer always has the latest complete
+// one to read, and neither ever waits for the other.
+template <typename T>
+class TripleBuffer {
+    private:
+        // set on the shared index when it holds a value not read yet
+        static const unsigned int FRESH = 4;
+
+        T buffers[3];
+        std::atomic<unsigned int> middle{1};
+        unsigned int back = 0;
+        unsigned int front = 2;
+
+    public:
+        // producer side
+        T& writeBuffer();
+        void publish();
+
+        // consumer side, update() returns false when nothing new was published
+        bool update();
+        const T& readBuffer() const;
+};
+
+template <typename T>
+T& TripleBuffer<T>::writeBuffer() {
+    return this->buffers[this->back];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish() {
+    this->back = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+template <typename T>
+bool TripleBuffer<T>::update() {
+    if (!(this->middle.load(std::memory_order_acquire) & FRESH)) return false;
+    this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::readBuffer() const {
+    return this->buffers[this->front];
+}
+
+#endif  // SIMULATION_TRIPLE_BUFFER_HPP_
@@ -0,0 +1,279 @@
+// headless parameter sweep, runs many independent flocks across the cores
+// and writes one row of summary statistics per run. links only the
+// simulation module, like the benchmark.
+#include "simulation/flock_simulation.hpp"
+#include "simulation/statistics.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// same defaults as the viewer
+const float boidSize = 0.3536;
+const float bound = 25.f;
+
+using Clock = std::chrono::steady_clock;
+
+// cpu time of the calling thread, lower than the wall time when the jobs
+// outnumber the cores
+double threadSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+struct SweepConfig {
+    std::vector<unsigned int> sizes = {1000};
+    std::vector<float> radii = {8*boidSize};
+    std::vector<float> alignments = {0.12f};
+    std::vector<float> cohesions = {0.12f};
+    std::vector<float> separations = {0.12f};
+    std::vector<float> maxSpeeds = {2.f};
+    unsigned int seeds = 1;
+    unsigned int firstSeed = 42;
+    unsigned int steps = 1200;
+    // steps between polarization samples over the second half of a run
+    unsigned int sample = 10;
+    float dt = 1.f / 120.f;
+    // simulations stepped at once, 0 for one per core
+    unsigned int jobs = 0;
+    std::string output;
+};
+
+// one point of the sweep
+struct SweepRun {
+    unsigned int index;
+    unsigned int n;
+    FlockParameters params;
+    unsigned int seed;
+};
+
+struct SweepResult {
+    FlockStatistics statistics;
+    // polarization averaged over the second half, steadier than the final one
+    double polarizationMean;
+    double seconds;
+    double cpuSeconds;
+};
+
+// comma separated values, each a number or a from:to:count range with both
+// ends included
+template <typename T>
+std::vector<T> parseValues(const char* text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        std::stringstream range(item);
+        std::string from, to, count;
+        if (std::getline(range, from, ':') && std::getline(range, to, ':') && std::getline(range, count)) {
+            double first = std::stod(from), last = std::stod(to);
+            int points = std::max(1, std::stoi(count));
+            for (int i = 0; i < points; i++) {
+                double value = points == 1 ? first : first + (last - first) * i / (points - 1);
+                values.push_back(static_cast<T>(value));
+            }
+        } else {
+            values.push_back(static_cast<T>(std::stod(item)));
+        }
+    }
+    return values;
+}
+
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options]" << std::endl
+              << "  every LIST is comma separated values or from:to:count ranges, e.g. 0:0.5:6" << std::endl
+              << "  --n LIST            flock sizes (default 1000)" << std::endl
+              << "  --radius LIST       perception radii (default 2.8288)" << std::endl
+              << "  --alignment LIST    alignment weights (default 0.12)" << std::endl
+              << "  --cohesion LIST     cohesion weights (default 0.12)" << std::endl
+              << "  --separation LIST   separation weights (default 0.12)" << std::endl
+              << "  --max-speed LIST    speed limits (default 2)" << std::endl
+              << "  --seeds N           random flocks per parameter set (default 1)" << std::endl
+              << "  --first-seed S      seed of the first flock, the others follow (default 42)" << std::endl
+              << "  --steps N           steps per run (default 1200)" << std::endl
+              << "  --sample N          steps between polarization samples (default 10)" << std::endl
+              << "  --dt SECONDS        time step (default 0.008333)" << std::endl
+              << "  --jobs N            simulations run at once, 0 for one per core (default 0)" << std::endl
+              << "  --out FILE          csv file, stdout when missing" << std::endl;
+}
+
+SweepConfig parseArguments(int argc, char** argv) {
+    SweepConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            std::exit(1);
+        }
+        const char* value = argv[++i];
+        if (arg == "--n") config.sizes = parseValues<unsigned int>(value);
+        else if (arg == "--radius") config.radii = parseValues<float>(value);
+        else if (arg == "--alignment") config.alignments = parseValues<float>(value);
+        else if (arg == "--cohesion") config.cohesions = parseValues<float>(value);
+        else if (arg == "--separation") config.separations = parseValues<float>(value);
+        else if (arg == "--max-speed") config.maxSpeeds = parseValues<float>(value);
+        else if (arg == "--seeds") config.seeds = std::atoi(value);
+        else if (arg == "--first-seed") config.firstSeed = std::atoi(value);
+        else if (arg == "--steps") config.steps = std::atoi(value);
+        else if (arg == "--sample") config.sample = std::max(1, std::atoi(value));
+        else if (arg == "--dt") config.dt = std::atof(value);
+        else if (arg == "--jobs") config.jobs = std::atoi(value);
+        else if (arg == "--out") config.output = value;
+        else {
+            usage(argv[0]);
+            std::exit(1);
+        }
+    }
+    return config;
+}
+
+std::vector<SweepRun> expand(const SweepConfig& config) {
+    std::vector<SweepRun> runs;
+    for (unsigned int n : config.sizes)
+    for (float radius : config.radii)
+    for (float alignment : config.alignments)
+    for (float cohesion : config.cohesions)
+    for (float separation : config.separations)
+    for (float maxSpeed : config.maxSpeeds)
+    for (unsigned int s = 0; s < config.seeds; s++) {
+        FlockParameters params = {radius, separation, cohesion, alignment, maxSpeed};
+        runs.push_back({static_cast<unsigned int>(runs.size()), n, params, config.firstSeed + s});
+    }
+    return runs;
+}
+
+// a single-threaded flock, the sweep gets its parallelism from running many
+SweepResult simulate(const SweepConfig& config, const SweepRun& run) {
+    Clock::time_point start = Clock::now();
+    double cpuStart = threadSeconds();
+
+    FlockSimulation simulation(1, bound);
+    simulation.setParameters(run.params);
+    simulation.setDt(config.dt);
+    simulation.randomize(run.n, run.seed);
+
+    double polarization = 0.0;
+    unsigned int samples = 0;
+    unsigned int half = config.steps / 2;
+    for (unsigned int step = 0; step < config.steps; step += config.sample) {
+        simulation.step(std::min(config.sample, config.steps - step));
+        if (step >= half) {
+            polarization += Statistics::polarization(simulation.state());
+            samples++;
+        }
+    }
+
+    SweepResult result;
+    result.statistics = Statistics::measure(simulation.state(), run.params.perceptionRadius, bound);
+    result.polarizationMean = samples > 0 ? polarization / samples : result.statistics.polarization;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.cpuSeconds = threadSeconds() - cpuStart;
+    return result;
+}
+
+void printResult(std::FILE* out, const SweepConfig& config, const SweepRun& run, const SweepResult& result) {
+    const FlockParameters& p = run.params;
+    const FlockStatistics& s = result.statistics;
+    std::fprintf(
+        out, "%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%u,%u,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f\n",
+        run.index, run.n, p.perceptionRadius, p.alignment, p.cohesion, p.separation, p.maxSpeed, run.seed,
+        config.steps, s.meanSpeed, s.speedDeviation, s.polarization, result.polarizationMean, s.meanNeighbors, result.seconds
+    );
+    std::fflush(out);
+}
+
+int main(int argc, char** argv) {
+    SweepConfig config = parseArguments(argc, argv);
+    std::vector<SweepRun> runs = expand(config);
+    if (runs.empty()) {
+        std::cerr << "the sweep is empty" << std::endl;
+        return 1;
+    }
+
+    std::FILE* out = stdout;
+    if (!config.output.empty()) {
+        out = std::fopen(config.output.c_str(), "w");
+        if (!out) {
+            std::cerr << "could not open " << config.output << std::endl;
+            return 1;
+        }
+    }
+    std::fprintf(out, "run,n,radius,alignment,cohesion,separation,max_speed,seed,steps,mean_speed,speed_deviation,polarization,polarization_mean,mean_neighbors,seconds\n");
+
+    // largest flocks first, so no long run is left for the end
+    std::vector<unsigned int> order(runs.size());
+    for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        const SweepRun& x = runs[a];
+        const SweepRun& y = runs[b];
+        if (x.n != y.n) return x.n > y.n;
+        return x.params.perceptionRadius > y.params.perceptionRadius;
+    });
+
+    unsigned int jobs = config.jobs > 0 ? config.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min<unsigned int>(jobs, runs.size());
+
+    // every job takes the next run as soon as it is free, rows are written
+    // as runs finish and carry the run index
+    std::atomic<unsigned int> next{0};
+    std::atomic<unsigned int> failures{0};
+    std::mutex outputMutex;
+    double busySeconds = 0.0;
+    unsigned int finished = 0;
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int j = 0; j < jobs; j++) {
+        threads.emplace_back([&]() {
+            for (unsigned int i = next++; i < order.size(); i = next++) {
+                const SweepRun& run = runs[order[i]];
+                SweepResult result;
+                try {
+                    result = simulate(config, run);
+                } catch (const std::exception& error) {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    std::cerr << "run " << run.index << " failed: " << error.what() << std::endl;
+                    failures++;
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                printResult(out, config, run, result);
+                busySeconds += result.cpuSeconds;
+                finished++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (out != stdout) std::fclose(out);
+
+    // busy is the cpu time spent inside runs per job and wall second, near
+    // 100% the throughput grows with the job count until memory bandwidth
+    // runs out
+    std::fprintf(
+        stderr, "%u runs in %.2f s with %u jobs: %.0f simulations/hour, %.1f simulations/hour per job, %.0f%% busy\n",
+        finished, seconds, jobs, finished * 3600.0 / seconds, finished * 3600.0 / seconds / jobs,
+        100.0 * busySeconds / (seconds * jobs)
+    );
+    return failures == 0 ? 0 : 1;
+}
@@ -2,6 +2,9 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+#include "utils/profiler.hpp"
+#include "utils/render_stats.hpp"
+
 void ImGui_UpdateStyle() {
     ImGuiStyle& style = ImGui::GetStyle();
     style.Colors[ImGuiCol_Text]                  = ImVec4(1.00f, 1.00f, 1.00f, 1.00f);
@@ -54,3 +57,79 @@ void ImGui_UpdateStyle() {
     style.Colors[ImGuiCol_ModalWindowDimBg]      = ImVec4(0.80f, 0.80f, 0.80f, 0.35f);
     style.GrabRounding                           = style.FrameRounding = 2.3f;
 }
+
+void ImGui_ProfilerPanel() {
+    bool enabled = Profiler::enabled;
+    if (ImGui::Checkbox("Enable Profiling", &enabled)) {
+        Profiler::enabled = enabled;
+    }
+    if (!enabled) return;
+
+    // statistics over the last two seconds
+    ImGui::Columns(3, "profilerPhases", false);
+    ImGui::Text("Phase"); ImGui::NextColumn();
+    ImGui::Text("p50 ms"); ImGui::NextColumn();
+    ImGui::Text("p99 ms"); ImGui::NextColumn();
+    for (int phase = 0; phase < Profiler::PhaseCount; phase++) {
+        Profiler::PhaseStats stats = Profiler::stats(static_cast<Profiler::Phase>(phase), 2.0);
+        ImGui::Text("%s", Profiler::name(static_cast<Profiler::Phase>(phase))); ImGui::NextColumn();
+        ImGui::Text("%.3f", stats.p50); ImGui::NextColumn();
+        ImGui::Text("%.3f", stats.p99); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    ImGui::Columns(2, "profilerExport", false);
+    if (ImGui::Button("Export CSV", ImVec2(115, 20))) {
+        Profiler::exportCsv("profile.csv");
+    }
+    ImGui::NextColumn();
+    if (ImGui::Button("Export Trace", ImVec2(115, 20))) {
+        Profiler::exportChromeTrace("profile.json");
+    }
+    ImGui::Columns(1);
+}
+
+void ImGui_RenderStatsPanel() {
+    bool enabled = RenderStats::isEnabled();
+    if (ImGui::Checkbox("GPU Stats", &enabled)) {
+        RenderStats::setEnabled(enabled);
+    }
+    if (!enabled) return;
+
+    // per frame, gpu times smoothed and a few frames late
+    ImGui::Columns(5, "renderPasses", false);
+    ImGui::Text("Pass"); ImGui::NextColumn();
+    ImGui::Text("GPU ms"); ImGui::NextColumn();
+    ImGui::Text("Draws"); ImGui::NextColumn();
+    ImGui::Text("Unif."); ImGui::NextColumn();
+    ImGui::Text("Binds"); ImGui::NextColumn();
+    RenderStats::PassStats total;
+    for (int pass = 0; pass < RenderStats::PassCount; pass++) {
+        RenderStats::PassStats stats = RenderStats::stats(static_cast<RenderStats::Pass>(pass));
+        ImGui::Text("%s", RenderStats::name(static_cast<RenderStats::Pass>(pass))); ImGui::NextColumn();
+        ImGui::Text("%.3f", stats.gpuMs); ImGui::NextColumn();
+        ImGui::Text("%lu", stats.counters.drawCalls); ImGui::NextColumn();
+        ImGui::Text("%lu", stats.counters.uniformUploads); ImGui::NextColumn();
+        ImGui::Text("%lu", stats.counters.bufferBinds); ImGui::NextColumn();
+        total.gpuMs += stats.gpuMs;
+        total.counters.drawCalls += stats.counters.drawCalls;
+        total.counters.uniformUploads += stats.counters.uniformUploads;
+        total.counters.bufferBinds += stats.counters.bufferBinds;
+        total.counters.vertices += stats.counters.vertices;
+    }
+    ImGui::Text("Total"); ImGui::NextColumn();
+    ImGui::Text("%.3f", total.gpuMs); ImGui::NextColumn();
+    ImGui::Text("%lu", total.counters.drawCalls); ImGui::NextColumn();
+    ImGui::Text("%lu", total.counters.uniformUploads); ImGui::NextColumn();
+    ImGui::Text("%lu", total.counters.bufferBinds); ImGui::NextColumn();
+    ImGui::Columns(1);
+    ImGui::Text("%lu vertices, %lu frames dropped", total.counters.vertices, RenderStats::droppedFrames());
+
+    if (ImGui::Button(RenderStats::isLogging() ? "Stop Log" : "Log CSV", ImVec2(-1, 20))) {
+        if (RenderStats::isLogging()) {
+            RenderStats::stopLog();
+        } else {
+            RenderStats::startLog("render_stats.csv");
+        }
+    }
+}
@@ -3,4 +3,11 @@
 
 void ImGui_UpdateStyle();
 
+// rolling p50/p99 per profiled phase, with export buttons
+void ImGui_ProfilerPanel();
+
+// gpu time, draws, uniform uploads, binds and vertices per render pass,
+// with a button that logs them to render_stats.csv
+void ImGui_RenderStatsPanel();
+
 #endif  // UTILS_IMGUI_HPP_
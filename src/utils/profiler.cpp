@@ -0,0 +1,157 @@
+#include "utils/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// samples kept per thread, a few seconds of frames at a high frame rate
+const unsigned int RING_SIZE = 16384;
+
+struct Sample {
+    uint64_t start;
+    uint64_t end;
+    uint64_t frame;
+    Profiler::Phase phase;
+};
+
+struct SampleRing {
+    unsigned int thread;
+    Sample samples[RING_SIZE];
+    std::atomic<uint64_t> head{0};
+
+    // copies the samples still in the ring, dropping any the owner
+    // overwrote while they were being read
+    std::vector<Sample> copy() const {
+        uint64_t last = this->head.load(std::memory_order_acquire);
+        uint64_t first = last > RING_SIZE ? last - RING_SIZE : 0;
+        std::vector<Sample> out;
+        out.reserve(last - first);
+        for (uint64_t i = first; i < last; i++) {
+            out.push_back(this->samples[i % RING_SIZE]);
+        }
+        // seqlock style: the slot reads above must not move past the second head load
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = this->head.load(std::memory_order_acquire);
+        // the owner may already be filling slot `after`, which shares a slot with after - RING_SIZE
+        uint64_t overwritten = after >= RING_SIZE ? after - RING_SIZE + 1 : 0;
+        if (overwritten > first) {
+            out.erase(out.begin(), out.begin() + std::min<uint64_t>(overwritten - first, out.size()));
+        }
+        return out;
+    }
+};
+
+std::atomic<bool> Profiler::enabled{false};
+std::atomic<uint64_t> currentFrame{0};
+std::mutex registryMutex;
+std::vector<std::shared_ptr<SampleRing>> registry;
+
+SampleRing& threadRing() {
+    // registered once per thread, kept alive after the thread exits
+    thread_local std::shared_ptr<SampleRing> ring = [] {
+        std::shared_ptr<SampleRing> created = std::make_shared<SampleRing>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        created->thread = registry.size();
+        registry.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+std::vector<std::shared_ptr<SampleRing>> rings() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return registry;
+}
+
+const char* Profiler::name(Phase phase) {
+    switch (phase) {
+        case Frame: return "Frame";
+        case GridBuild: return "Grid build";
+        case FlockUpdate: return "Flock update";
+        case Reorder: return "Reorder";
+        case RenderScene: return "Render scene";
+        case RenderBoids: return "Render boids";
+        case ImGuiPass: return "ImGui";
+        case SwapBuffers: return "Swap buffers";
+        case Capture: return "Capture";
+        default: return "Unknown";
+    }
+}
+
+uint64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+void Profiler::record(Phase phase, uint64_t start, uint64_t end) {
+    SampleRing& ring = threadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.samples[head % RING_SIZE] = {start, end, currentFrame.load(std::memory_order_relaxed), phase};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::nextFrame() {
+    currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+Profiler::PhaseStats Profiler::stats(Phase phase, double seconds) {
+    uint64_t since = Profiler::now() - static_cast<uint64_t>(seconds * 1e9);
+    std::vector<double> durations;
+    for (const std::shared_ptr<SampleRing>& ring : rings()) {
+        for (const Sample& sample : ring->copy()) {
+            if (sample.phase == phase && sample.start >= since) {
+                durations.push_back((sample.end - sample.start) * 1e-6);
+            }
+        }
+    }
+
+    PhaseStats result;
+    result.samples = durations.size();
+    if (durations.empty()) return result;
+
+    std::sort(durations.begin(), durations.end());
+    result.p50 = durations[(durations.size() - 1) * 50 / 100];
+    result.p99 = durations[(durations.size() - 1) * 99 / 100];
+    return result;
+}
+
+bool Profiler::exportCsv(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "thread,frame,phase,start_ns,duration_ns\n";
+    for (const std::shared_ptr<SampleRing>& ring : rings()) {
+        for (const Sample& sample : ring->copy()) {
+            file << ring->thread << ',' << sample.frame << ',' << Profiler::name(sample.phase) << ','
+                 << sample.start << ',' << sample.end - sample.start << '\n';
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    // complete events ("ph": "X") in microseconds, loads in chrome://tracing and perfetto
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+    bool first = true;
+    for (const std::shared_ptr<SampleRing>& ring : rings()) {
+        for (const Sample& sample : ring->copy()) {
+            file << (first ? "\n" : ",\n")
+                 << "  {\"name\": \"" << Profiler::name(sample.phase) << "\", \"ph\": \"X\", \"pid\": 1"
+                 << ", \"tid\": " << ring->thread
+                 << ", \"ts\": " << sample.start / 1000.0
+                 << ", \"dur\": " << (sample.end - sample.start) / 1000.0
+                 << ", \"args\": {\"frame\": " << sample.frame << "}}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
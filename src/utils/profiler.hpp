@@ -0,0 +1,70 @@
+#ifndef UTILS_PROFILER_HPP_
+#define UTILS_PROFILER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// scoped timers for the hot paths. each thread writes its samples into its
+// own ring buffer without locking, readers (the ui, the exporters) copy the
+// rings when they need them. a disabled profiler costs one relaxed load per
+// scope, building with -DBOIDS_NO_PROFILING removes the scopes entirely.
+namespace Profiler {
+    enum Phase {
+        Frame,
+        GridBuild,
+        FlockUpdate,
+        Reorder,
+        RenderScene,
+        RenderBoids,
+        ImGuiPass,
+        SwapBuffers,
+        Capture,
+        PhaseCount
+    };
+
+    struct PhaseStats {
+        unsigned int samples = 0;
+        double p50 = 0.0;
+        double p99 = 0.0;
+    };
+
+    extern std::atomic<bool> enabled;
+
+    const char* name(Phase phase);
+    uint64_t now();
+    void record(Phase phase, uint64_t start, uint64_t end);
+
+    // called once per rendered frame, tags the samples that follow
+    void nextFrame();
+
+    // percentiles in milliseconds over the samples of the last seconds
+    PhaseStats stats(Phase phase, double seconds);
+
+    bool exportCsv(const std::string& path);
+    bool exportChromeTrace(const std::string& path);
+}
+
+class ScopedTimer {
+    private:
+        Profiler::Phase phase;
+        uint64_t start = 0;
+
+    public:
+        ScopedTimer(Profiler::Phase phase) : phase(phase) {
+            if (Profiler::enabled.load(std::memory_order_relaxed)) this->start = Profiler::now();
+        }
+        ~ScopedTimer() {
+            if (this->start) Profiler::record(this->phase, this->start, Profiler::now());
+        }
+};
+
+#ifdef BOIDS_NO_PROFILING
+#define PROFILE_SCOPE(phase)
+#else
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(phase) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#endif
+
+#endif  // UTILS_PROFILER_HPP_
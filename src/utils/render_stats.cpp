@@ -0,0 +1,171 @@
+#include "utils/render_stats.hpp"
+
+#include "glad/glad.h"
+
+#include <cstdio>
+#include <iostream>
+
+// frames of queries in flight, results are read this many frames late
+const unsigned int FRAMES_IN_FLIGHT = 4;
+// weight of the newest frame in the smoothed gpu times
+const double SMOOTHING = 0.05;
+
+struct FrameSlot {
+    GLuint queries[RenderStats::PassCount] = {};
+    bool timed[RenderStats::PassCount] = {};
+    RenderStats::Counters counters[RenderStats::PassCount];
+    unsigned long frame = 0;
+    bool pending = false;
+};
+
+RenderStats::Counters* RenderStats::current = nullptr;
+
+static bool enabled = false;
+static bool created = false;
+static FrameSlot slots[FRAMES_IN_FLIGHT];
+static unsigned long frame = 0;
+static bool openQuery = false;
+static RenderStats::PassStats results[RenderStats::PassCount];
+static unsigned long dropped = 0;
+static std::FILE* logFile = nullptr;
+
+static void create() {
+    for (FrameSlot& slot : slots) {
+        glGenQueries(RenderStats::PassCount, slot.queries);
+    }
+    created = true;
+}
+
+static void resetSlot(FrameSlot& slot) {
+    for (int pass = 0; pass < RenderStats::PassCount; pass++) {
+        slot.timed[pass] = false;
+        slot.counters[pass] = RenderStats::Counters();
+    }
+    slot.pending = false;
+}
+
+// reads a finished frame, or drops it when any query is still running
+static void collect(FrameSlot& slot) {
+    for (int pass = 0; pass < RenderStats::PassCount; pass++) {
+        if (!slot.timed[pass]) continue;
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(slot.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            dropped++;
+            return;
+        }
+    }
+
+    for (int pass = 0; pass < RenderStats::PassCount; pass++) {
+        RenderStats::PassStats& result = results[pass];
+        result.counters = slot.counters[pass];
+        // passes that did not run fade out to zero
+        double gpuMs = 0.0;
+        if (slot.timed[pass]) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(slot.queries[pass], GL_QUERY_RESULT, &nanoseconds);
+            gpuMs = nanoseconds * 1e-6;
+        }
+        result.gpuMs += (gpuMs - result.gpuMs) * SMOOTHING;
+
+        if (logFile && slot.timed[pass]) {
+            const RenderStats::Counters& c = slot.counters[pass];
+            std::fprintf(
+                logFile, "%lu,%s,%.4f,%lu,%lu,%lu,%lu\n", slot.frame, RenderStats::name(static_cast<RenderStats::Pass>(pass)),
+                gpuMs, c.drawCalls, c.uniformUploads, c.bufferBinds, c.vertices
+            );
+        }
+    }
+}
+
+bool RenderStats::isEnabled() {
+    return enabled;
+}
+
+void RenderStats::setEnabled(bool value) {
+    if (!value) {
+        endPass();
+        for (FrameSlot& slot : slots) {
+            resetSlot(slot);
+        }
+    }
+    enabled = value;
+}
+
+const char* RenderStats::name(Pass pass) {
+    switch (pass) {
+        case Cube: return "Cube";
+        case Grid: return "Grid";
+        case Overlays: return "Overlays";
+        case Birds: return "Birds";
+        case Interface: return "ImGui";
+        case GpuStep: return "GPU step";
+        default: return "Unknown";
+    }
+}
+
+void RenderStats::beginFrame() {
+    endPass();
+    if (!enabled) return;
+    if (!created) create();
+
+    frame++;
+    FrameSlot& slot = slots[frame % FRAMES_IN_FLIGHT];
+    if (slot.pending) collect(slot);
+    resetSlot(slot);
+    slot.frame = frame;
+    slot.pending = true;
+}
+
+void RenderStats::beginPass(Pass pass) {
+    endPass();
+    if (!enabled || frame == 0) return;
+
+    // a pass opened twice in a frame is counted twice but timed once,
+    // the query of the first run is still the one in flight
+    FrameSlot& slot = slots[frame % FRAMES_IN_FLIGHT];
+    if (!slot.timed[pass]) {
+        glBeginQuery(GL_TIME_ELAPSED, slot.queries[pass]);
+        slot.timed[pass] = true;
+        openQuery = true;
+    }
+    current = &slot.counters[pass];
+}
+
+void RenderStats::endPass() {
+    if (openQuery) {
+        glEndQuery(GL_TIME_ELAPSED);
+        openQuery = false;
+    }
+    current = nullptr;
+}
+
+RenderStats::PassStats RenderStats::stats(Pass pass) {
+    return results[pass];
+}
+
+unsigned long RenderStats::droppedFrames() {
+    return dropped;
+}
+
+bool RenderStats::startLog(const std::string& path) {
+    stopLog();
+    logFile = std::fopen(path.c_str(), "w");
+    if (!logFile) {
+        std::cerr << "could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+    std::fprintf(logFile, "frame,pass,gpu_ms,draw_calls,uniform_uploads,buffer_binds,vertices\n");
+    setEnabled(true);
+    return true;
+}
+
+void RenderStats::stopLog() {
+    if (!logFile) return;
+    std::fclose(logFile);
+    logFile = nullptr;
+}
+
+bool RenderStats::isLogging() {
+    return logFile != nullptr;
+}
@@ -0,0 +1,83 @@
+#ifndef UTILS_RENDER_STATS_HPP_
+#define UTILS_RENDER_STATS_HPP_
+
+#include <string>
+
+// gpu time and driver calls per render pass. each pass of a frame runs
+// inside a GL_TIME_ELAPSED query; the queries of a frame are read a few
+// frames later, once their results are available, so reading them never
+// waits for the gpu. Mesh, InstancedMesh, Shader and UniformBuffer report
+// their draws, uniform uploads and binds to the pass that is open. render
+// thread only, and nothing is counted or timed while disabled.
+namespace RenderStats {
+    enum Pass {
+        Cube,
+        Grid,
+        Overlays,
+        Birds,
+        Interface,
+        GpuStep,
+        PassCount
+    };
+
+    struct Counters {
+        unsigned long drawCalls = 0;
+        unsigned long uniformUploads = 0;
+        unsigned long bufferBinds = 0;
+        unsigned long vertices = 0;
+    };
+
+    struct PassStats {
+        // smoothed over the last frames, counters of the last measured frame
+        double gpuMs = 0.0;
+        Counters counters;
+    };
+
+    // counters of the open pass, null outside passes or while disabled
+    extern Counters* current;
+
+    bool isEnabled();
+    void setEnabled(bool enabled);
+    const char* name(Pass pass);
+
+    // at the start of every frame, collects the results of older frames
+    void beginFrame();
+    void beginPass(Pass pass);
+    void endPass();
+
+    PassStats stats(Pass pass);
+    // frames whose queries were not ready when their slot came back
+    unsigned long droppedFrames();
+
+    // one csv row per pass and measured frame, enables the stats
+    bool startLog(const std::string& path);
+    void stopLog();
+    bool isLogging();
+
+    inline void draw(unsigned long vertices) {
+        if (current) {
+            current->drawCalls++;
+            current->vertices += vertices;
+        }
+    }
+
+    inline void uniform() {
+        if (current) current->uniformUploads++;
+    }
+
+    inline void bind() {
+        if (current) current->bufferBinds++;
+    }
+}
+
+class RenderPassScope {
+    public:
+        RenderPassScope(RenderStats::Pass pass) {
+            RenderStats::beginPass(pass);
+        }
+        ~RenderPassScope() {
+            RenderStats::endPass();
+        }
+};
+
+#endif  // UTILS_RENDER_STATS_HPP_
@@ -0,0 +1,116 @@
+#include "utils/video_writer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+VideoWriter::~VideoWriter() {
+    this->close();
+}
+
+bool VideoWriter::open(const std::string& path, unsigned int width, unsigned int height, unsigned int fps) {
+    this->close();
+    this->y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    this->width = width;
+    this->height = height;
+    this->frames = 0;
+
+    this->file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+    if (!this->file) {
+        std::cerr << "could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    if (this->y4m) {
+        unsigned int chromaSize = ((width + 1) / 2) * ((height + 1) / 2);
+        this->planes.resize(width * height + 2 * chromaSize);
+        std::fprintf(this->file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    } else {
+        this->planes.resize(width * height * 3);
+    }
+    return true;
+}
+
+// fixed point bt.601 full range, weights scaled by 2^16
+static inline uint8_t luma(int r, int g, int b) {
+    return static_cast<uint8_t>((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+}
+
+static inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+bool VideoWriter::write(const uint8_t* rgba) {
+    if (!this->file) return false;
+
+    unsigned int w = this->width, h = this->height;
+    uint8_t* out = this->planes.data();
+    if (this->y4m) {
+        unsigned int cw = (w + 1) / 2, ch = (h + 1) / 2;
+        uint8_t* lumaPlane = out;
+        uint8_t* cbPlane = out + w * h;
+        uint8_t* crPlane = cbPlane + cw * ch;
+
+        // rows are flipped while converting, gl starts at the bottom
+        for (unsigned int y = 0; y < h; y++) {
+            const uint8_t* row = rgba + static_cast<size_t>(h - 1 - y) * w * 4;
+            uint8_t* target = lumaPlane + static_cast<size_t>(y) * w;
+            for (unsigned int x = 0; x < w; x++) {
+                target[x] = luma(row[4 * x], row[4 * x + 1], row[4 * x + 2]);
+            }
+        }
+
+        // chroma of each 2x2 block, edges of odd sizes reuse the last pixel
+        for (unsigned int cy = 0; cy < ch; cy++) {
+            for (unsigned int cx = 0; cx < cw; cx++) {
+                int r = 0, g = 0, b = 0;
+                for (unsigned int dy = 0; dy < 2; dy++) {
+                    unsigned int y = std::min(2 * cy + dy, h - 1);
+                    const uint8_t* row = rgba + static_cast<size_t>(h - 1 - y) * w * 4;
+                    for (unsigned int dx = 0; dx < 2; dx++) {
+                        unsigned int x = std::min(2 * cx + dx, w - 1);
+                        r += row[4 * x];
+                        g += row[4 * x + 1];
+                        b += row[4 * x + 2];
+                    }
+                }
+                // sums of four pixels, so the scale is 2^18
+                cbPlane[cy * cw + cx] = clampByte(((-11059 * r - 21709 * g + 32768 * b) >> 18) + 128);
+                crPlane[cy * cw + cx] = clampByte(((32768 * r - 27439 * g - 5329 * b) >> 18) + 128);
+            }
+        }
+        if (std::fputs("FRAME\n", this->file) < 0) return false;
+    } else {
+        for (unsigned int y = 0; y < h; y++) {
+            const uint8_t* row = rgba + static_cast<size_t>(h - 1 - y) * w * 4;
+            uint8_t* target = out + static_cast<size_t>(y) * w * 3;
+            for (unsigned int x = 0; x < w; x++) {
+                target[3 * x] = row[4 * x];
+                target[3 * x + 1] = row[4 * x + 1];
+                target[3 * x + 2] = row[4 * x + 2];
+            }
+        }
+        if (std::fprintf(this->file, "P6\n%u %u\n255\n", w, h) < 0) return false;
+    }
+
+    if (std::fwrite(out, 1, this->planes.size(), this->file) != this->planes.size()) return false;
+    this->frames++;
+    return true;
+}
+
+void VideoWriter::close() {
+    if (!this->file) return;
+    if (this->file == stdout) {
+        std::fflush(this->file);
+    } else {
+        std::fclose(this->file);
+    }
+    this->file = nullptr;
+}
+
+bool VideoWriter::isOpen() const {
+    return this->file != nullptr;
+}
+
+unsigned long VideoWriter::getFrames() const {
+    return this->frames;
+}
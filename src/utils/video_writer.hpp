@@ -0,0 +1,36 @@
+#ifndef UTILS_VIDEO_WRITER_HPP_
+#define UTILS_VIDEO_WRITER_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// uncompressed video stream for other tools to encode: y4m (4:2:0, full
+// range bt.601) when the path ends in .y4m, concatenated binary ppm frames
+// otherwise. "-" writes to stdout, e.g. piped into ffmpeg.
+class VideoWriter {
+    private:
+        std::FILE* file = nullptr;
+        bool y4m = true;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned long frames = 0;
+        std::vector<uint8_t> planes;
+
+    public:
+        VideoWriter() = default;
+        VideoWriter(const VideoWriter&) = delete;
+        VideoWriter& operator=(const VideoWriter&) = delete;
+        ~VideoWriter();
+
+        bool open(const std::string& path, unsigned int width, unsigned int height, unsigned int fps);
+        // rgba pixels with the bottom row first, as glReadPixels returns them
+        bool write(const uint8_t* rgba);
+        void close();
+
+        bool isOpen() const;
+        unsigned long getFrames() const;
+};
+
+#endif  // UTILS_VIDEO_WRITER_HPP_